@@ -0,0 +1,154 @@
+#include "claimmanager.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <signal.h>
+#include <unistd.h>
+
+// local
+#include "sessionpool.h"
+
+/**
+ * Returns the process wide claim manager.
+ *
+ * @return A reference to the ClaimManager.
+ *
+ * @throws None
+ */
+ClaimManager &ClaimManager::instance() {
+    static ClaimManager manager;
+    return manager;
+}
+
+/**
+ * Constructs the manager with the name of this instance and starts the heartbeat.
+ *
+ * @throws None
+ */
+ClaimManager::ClaimManager() {
+    // The sessions are borrowed from the SessionPool, so it has to be destroyed after the manager
+    SessionPool::instance();
+    char hostName[256] {};
+    gethostname(hostName, sizeof(hostName) - 1);
+    m_hostName = hostName;
+    m_instance = m_hostName + "-" + std::to_string(getpid());
+    m_worker = std::thread(&ClaimManager::run, this);
+}
+
+/**
+ * Stops the heartbeat. The claims left are recovered by other instances after the timeout,
+ * or right away by the next instance on this host.
+ *
+ * @throws None
+ */
+ClaimManager::~ClaimManager() {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_changed.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+/**
+ * Moves the files of orphaned claims in a directory back, so they are listed again.
+ *
+ * @param directory The url of the listed directory.
+ *
+ * @throws None
+ */
+void ClaimManager::recover(ParseUrl directory) {
+    FtpConnection ftpConnection(directory);
+    ftpConnection.recoverClaims(m_instance, [this](const std::string &instance, int64_t age) {
+        return isOrphaned(instance, age);
+    });
+}
+
+/**
+ * Claims listed files for this instance, the directory is kept alive from then on.
+ *
+ * @param directory The url of the listed directory.
+ * @param files The files to claim. Receives the files claimed with their new path, the
+ *              files claimed by another instance meanwhile are left out.
+ *
+ * @throws None
+ */
+void ClaimManager::claim(ParseUrl directory, std::vector<FtpConnection::remoteFile> &files) {
+    if (files.empty()) {
+        return;
+    }
+    FtpConnection ftpConnection(directory);
+    ftpConnection.claimFiles(m_instance, files);
+
+    #ifdef DEBUG
+        std::cout << "ClaimManager::claim: " << files.size() << " files claimed as " << m_instance << std::endl;
+    #endif
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_directories.emplace(directory.Url(), directory);
+}
+
+/**
+ * Touches the claim directories of this instance every cHeartbeat until it is stopped.
+ *
+ * @throws None
+ */
+void ClaimManager::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_changed.wait_for(lock, cHeartbeat, [this] { return m_isStopping; })) {
+        const std::map<std::string, ParseUrl> directories {m_directories};
+        lock.unlock();
+        for (const auto &[url, directory] : directories) {
+            FtpConnection ftpConnection(directory);
+            if (!ftpConnection.touchClaims(m_instance)) {
+                std::cerr << "Could not renew the claims in " << directory.Directory() << " on " << directory.Host() << std::endl;
+            }
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Checks whether the claims of an instance are orphaned.
+ *
+ * @param instance The name of the instance, its host name and process id.
+ * @param age The seconds since its claim directory was touched, by the server's clock.
+ *
+ * @return true if the instance ran on this host and its process is gone, or if it did not touch its claims for cClaimTimeout.
+ *
+ * @throws None
+ */
+bool ClaimManager::isOrphaned(const std::string &instance, int64_t age) const {
+    if (instance == m_instance) {
+        return false;
+    }
+    const size_t dash {instance.rfind('-')};
+    if (dash != std::string::npos && instance.compare(0, dash, m_hostName) == 0 && dash == m_hostName.size()) {
+        const pid_t pid {static_cast<pid_t>(std::atol(instance.c_str() + dash + 1))};
+        if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+            return true;
+        }
+    }
+    return age > cClaimTimeout.count();
+}
+
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,77 @@
+#ifndef CLAIMMANAGER_H
+#define CLAIMMANAGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// local
+#include "ftpconnection.h"
+#include "parseurl.h"
+
+/*
+    Coordinates instances processing the same remote directory.
+    Before files are offered, this instance claims them by moving them into a claim
+    directory of its own, named after the host and process id. The claim directories
+    are touched every cHeartbeat while the instance runs. Claims whose directory was not
+    touched for cClaimTimeout, or whose process on this host is gone, are orphaned and
+    their files are moved back by the next instance scanning the directory.
+    Touching and the age of a claim both use the server's clock, the clocks of the hosts
+    running the instances may differ.
+*/
+class ClaimManager {
+
+public:
+    static ClaimManager &instance();
+
+    void recover(ParseUrl directory);
+    void claim(ParseUrl directory, std::vector<FtpConnection::remoteFile> &files);
+
+private:
+    ClaimManager();
+    ~ClaimManager();
+    ClaimManager(const ClaimManager &) = delete;
+    ClaimManager &operator=(const ClaimManager &) = delete;
+
+    static constexpr std::chrono::seconds cHeartbeat {60};
+    static constexpr std::chrono::seconds cClaimTimeout {600};
+
+    std::string m_hostName;
+    std::string m_instance;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_isStopping {false};
+    // Directories with claims of this instance by their url
+    std::map<std::string, ParseUrl> m_directories;
+
+    // Started last, after all members are initialized
+    std::thread m_worker;
+
+    void run();
+    bool isOrphaned(const std::string &instance, int64_t age) const;
+};
+
+#endif // CLAIMMANAGER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
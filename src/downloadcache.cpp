@@ -0,0 +1,296 @@
+#include "downloadcache.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+//Qt 6.x
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QString>
+
+/**
+ * Returns the process wide download cache.
+ *
+ * @return A reference to the DownloadCache.
+ *
+ * @throws None
+ */
+DownloadCache &DownloadCache::instance() {
+    static DownloadCache cache;
+    return cache;
+}
+
+/**
+ * Sets the size limit of the cache, files above it are removed right away.
+ *
+ * @param maxBytes The disk space for cached files in bytes, 0 to cache no file.
+ *
+ * @throws None
+ */
+void DownloadCache::Limit(uint64_t maxBytes) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    if (m_isLoaded) {
+        evict();
+    }
+}
+
+/**
+ * Reads a file from the cache.
+ *
+ * @param host The host of the file as user@host:port.
+ * @param path The path of the file on the host.
+ * @param size The size of the remote file.
+ * @param mtime The modification time of the remote file.
+ *
+ * @return The content of the file, nullptr if the file is not cached.
+ *
+ * @throws None
+ */
+std::unique_ptr<std::string> DownloadCache::get(const std::string &host, const std::string &path, uint64_t size, int64_t mtime) {
+    const std::string key {keyHash(host, path, size, mtime)};
+    std::filesystem::path cacheFile;
+    std::string expectedHash;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_maxBytes == 0) {
+            return nullptr;
+        }
+        load();
+        auto it {m_entries.find(key)};
+        if (it == m_entries.end()) {
+            return nullptr;
+        }
+        cacheFile = fileName(key, it->second.contentHash);
+        expectedHash = it->second.contentHash;
+        // The modification time of the cache file keeps the order of use across restarts
+        it->second.lastUsed = std::filesystem::file_time_type::clock::now();
+        std::error_code error;
+        std::filesystem::last_write_time(cacheFile, it->second.lastUsed, error);
+    }
+
+    // Read outside the lock, the file may be removed meanwhile and is missed then
+    std::ifstream file(cacheFile, std::ios::in | std::ios::binary);
+    if (file.is_open()) {
+        std::unique_ptr<std::string> data {std::make_unique<std::string>(size, '\0')};
+        const bool isRead {file.read(data->data(), size) && file.peek() == std::ifstream::traits_type::eof()};
+        if (isRead && contentHash(*data) == expectedHash) {
+            #ifdef DEBUG
+                std::cout << "DownloadCache::get: " << path << " from " << cacheFile << std::endl;
+            #endif
+            return data;
+        }
+        std::cerr << "Removing damaged cache file " << cacheFile << std::endl;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    auto it {m_entries.find(key)};
+    if (it != m_entries.end() && it->second.contentHash == expectedHash) {
+        m_totalBytes -= it->second.size;
+        m_entries.erase(it);
+    }
+    std::error_code error;
+    std::filesystem::remove(cacheFile, error);
+    return nullptr;
+}
+
+/**
+ * Stores a downloaded file in the cache, replacing an older version of it.
+ *
+ * @param host The host of the file as user@host:port.
+ * @param path The path of the file on the host.
+ * @param size The size of the remote file, the size of the data.
+ * @param mtime The modification time of the remote file.
+ * @param data The content of the file.
+ * @param checksum The SHA-256 of the data as hex string if it is known, otherwise it is calculated.
+ *
+ * @throws None
+ */
+void DownloadCache::put(const std::string &host, const std::string &path, uint64_t size, int64_t mtime, const std::string &data,
+                        const std::string &checksum) {
+    const std::string key {keyHash(host, path, size, mtime)};
+    std::filesystem::path temporaryName;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (data.size() != size || size > m_maxBytes) {
+            return;
+        }
+        load();
+        if (m_entries.count(key) > 0) {
+            return;
+        }
+        // Instances sharing the cache tell their temporary files apart by the process id
+        temporaryName = m_directory / (key + "." + std::to_string(getpid()) + "-" + std::to_string(m_writeCounter++) + ".tmp");
+    }
+
+    // Written outside the lock to a temporary file, only complete files get their final name
+    const std::string hash {checksum.empty() ? contentHash(data) : checksum};
+    bool isWritten {false};
+    const int fd {open(temporaryName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600)};
+    if (fd >= 0) {
+        size_t written {0};
+        while (written < data.size()) {
+            const ssize_t count {write(fd, data.data() + written, data.size() - written)};
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(count);
+        }
+        isWritten = (written == data.size());
+        isWritten = (close(fd) == 0) && isWritten;
+    }
+    std::error_code error;
+    if (!isWritten) {
+        std::cerr << "Error writing cache file " << temporaryName << std::endl;
+        std::filesystem::remove(temporaryName, error);
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    const std::filesystem::path cacheFile {fileName(key, hash)};
+    std::filesystem::rename(temporaryName, cacheFile, error);
+    if (error) {
+        std::cerr << "Error writing cache file " << cacheFile << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporaryName, error);
+        return;
+    }
+    entry &cached {m_entries[key]};
+    if (!cached.contentHash.empty() && cached.contentHash != hash) {
+        std::filesystem::remove(fileName(key, cached.contentHash), error);
+    }
+    m_totalBytes = m_totalBytes - cached.size + size;
+    cached = {hash, size, std::filesystem::file_time_type::clock::now()};
+    evict();
+}
+
+/**
+ * Reads the cached files from the cache directory on first use. Temporary files left by
+ * an interrupted write of this process or older than cStaleTemporary are removed, younger
+ * ones may still be written by another instance. Has to be called with the mutex locked.
+ *
+ * @throws None
+ */
+void DownloadCache::load() {
+    if (m_isLoaded) {
+        return;
+    }
+    m_isLoaded = true;
+    m_directory = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "downloads";
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    std::filesystem::permissions(m_directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace, error);
+
+    const std::string ownTemporary {"." + std::to_string(getpid()) + "-"};
+    const auto staleTime {std::filesystem::file_time_type::clock::now() - cStaleTemporary};
+    for (const auto &file : std::filesystem::directory_iterator(m_directory, error)) {
+        // Cache files are named <key hash>-<content hash>, temporary files <key hash>.<pid>-<counter>.tmp
+        const std::string name {file.path().filename().string()};
+        const size_t separator {name.find('-')};
+        if (file.path().extension() == ".tmp") {
+            if (name.find(ownTemporary) != std::string::npos || file.last_write_time(error) < staleTime) {
+                std::filesystem::remove(file.path(), error);
+            }
+            continue;
+        }
+        if (separator == std::string::npos || name.find('.') != std::string::npos) {
+            std::filesystem::remove(file.path(), error);
+            continue;
+        }
+        m_entries[name.substr(0, separator)] = {name.substr(separator + 1), file.file_size(error), file.last_write_time(error)};
+        m_totalBytes += m_entries[name.substr(0, separator)].size;
+    }
+
+    #ifdef DEBUG
+        std::cout << "DownloadCache::load: " << m_entries.size() << " files, " << m_totalBytes << " bytes in " << m_directory << std::endl;
+    #endif
+    evict();
+}
+
+/**
+ * Removes the least recently used files until the cache fits into its limit.
+ * Has to be called with the mutex locked.
+ *
+ * @throws None
+ */
+void DownloadCache::evict() {
+    while (m_totalBytes > m_maxBytes && !m_entries.empty()) {
+        auto oldest {m_entries.begin()};
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        std::error_code error;
+        std::filesystem::remove(fileName(oldest->first, oldest->second.contentHash), error);
+        m_totalBytes -= oldest->second.size;
+        m_entries.erase(oldest);
+    }
+}
+
+/**
+ * Returns the name of a cache file.
+ *
+ * @param keyHash The hash of the key.
+ * @param contentHash The hash of the content.
+ *
+ * @return The path of the file in the cache directory.
+ *
+ * @throws None
+ */
+std::filesystem::path DownloadCache::fileName(const std::string &keyHash, const std::string &contentHash) const {
+    return m_directory / (keyHash + "-" + contentHash);
+}
+
+/**
+ * Returns the hash identifying a version of a remote file.
+ *
+ * @param host The host of the file as user@host:port.
+ * @param path The path of the file on the host.
+ * @param size The size of the remote file.
+ * @param mtime The modification time of the remote file.
+ *
+ * @return The SHA-256 of the key as hex string.
+ *
+ * @throws None
+ */
+std::string DownloadCache::keyHash(const std::string &host, const std::string &path, uint64_t size, int64_t mtime) {
+    const std::string key {host + '\n' + path + '\n' + std::to_string(size) + '\n' + std::to_string(mtime)};
+    return contentHash(key);
+}
+
+/**
+ * Returns the hash of data.
+ *
+ * @param data The data.
+ *
+ * @return The SHA-256 of the data as hex string.
+ *
+ * @throws None
+ */
+std::string DownloadCache::contentHash(const std::string &data) {
+    return QCryptographicHash::hash(QByteArray::fromRawData(data.data(), data.size()), QCryptographicHash::Sha256).toHex().toStdString();
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
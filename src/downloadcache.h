@@ -0,0 +1,79 @@
+#ifndef DOWNLOADCACHE_H
+#define DOWNLOADCACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+    Process wide disk cache of downloaded remote files.
+    A file is found by its host, path, size and modification time, so a changed remote
+    file is downloaded again. The cache files are named after the SHA-256 of this key and
+    of their content, which is checked when a file is read from the cache.
+    The cache directory and its files are only accessible by the user, they hold the content
+    of the scanned documents.
+    The least recently used files are removed when the cache exceeds its size limit.
+*/
+class DownloadCache {
+
+public:
+    static DownloadCache &instance();
+
+    std::unique_ptr<std::string> get(const std::string &host, const std::string &path, uint64_t size, int64_t mtime);
+    void put(const std::string &host, const std::string &path, uint64_t size, int64_t mtime, const std::string &data,
+             const std::string &checksum = std::string());
+    void Limit(uint64_t maxBytes);
+
+    static std::string keyHash(const std::string &host, const std::string &path, uint64_t size, int64_t mtime);
+
+private:
+    DownloadCache() = default;
+    DownloadCache(const DownloadCache &) = delete;
+    DownloadCache &operator=(const DownloadCache &) = delete;
+
+    struct entry {
+        std::string contentHash;
+        uint64_t size {0};
+        std::filesystem::file_time_type lastUsed;
+    };
+
+    // Temporary files of other instances sharing the cache are only removed once they are this old
+    static constexpr std::chrono::hours cStaleTemporary {1};
+
+    std::mutex m_mutex;
+    std::filesystem::path m_directory;
+    bool m_isLoaded {false};
+    // By the hash of the key
+    std::map<std::string, entry> m_entries;
+    uint64_t m_totalBytes {0};
+    uint64_t m_maxBytes {0};
+    uint64_t m_writeCounter {0};
+
+    void load();
+    void evict();
+    std::filesystem::path fileName(const std::string &keyHash, const std::string &contentHash) const;
+    static std::string contentHash(const std::string &data);
+};
+
+#endif // DOWNLOADCACHE_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,92 @@
+#include "filescheduler.h"
+
+#include <algorithm>
+#include <iostream>
+
+/**
+ * Adds a file to the queue of its source.
+ *
+ * @param pdfFile The file.
+ *
+ * @throws None
+ */
+void FileScheduler::add(const std::shared_ptr<PdfFile> &pdfFile) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_waiting[pdfFile->Source()].push_back(pdfFile);
+}
+
+/**
+ * Schedules the next waiting file, taking the sources in turn.
+ *
+ * @param depth The number of files scheduled ahead of processing at most.
+ *
+ * @return The file scheduled, nullptr if no file is waiting or enough files are scheduled.
+ *
+ * @throws None
+ */
+std::shared_ptr<PdfFile> FileScheduler::schedule(size_t depth) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_waiting.empty() || m_scheduled.size() >= depth) {
+        return nullptr;
+    }
+
+    auto source {m_waiting.upper_bound(m_lastSource)};
+    if (source == m_waiting.end()) {
+        source = m_waiting.begin();
+    }
+    std::shared_ptr<PdfFile> pdfFile {std::move(source->second.front())};
+    source->second.pop_front();
+    m_lastSource = source->first;
+    if (source->second.empty()) {
+        m_waiting.erase(source);
+    }
+    m_scheduled.push_back(pdfFile);
+
+    #ifdef DEBUG
+        std::cout << "FileScheduler::schedule: " << pdfFile->SourceFileName() << " from " << m_lastSource << ", "
+                  << m_scheduled.size() << " scheduled" << std::endl;
+    #endif
+    return pdfFile;
+}
+
+/**
+ * Takes the file to process next from the scheduled files: the first one downloaded
+ * completely, or the first one if none is.
+ *
+ * @return The file, nullptr if no file is scheduled.
+ *
+ * @throws None
+ */
+std::shared_ptr<PdfFile> FileScheduler::next() {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_scheduled.empty()) {
+        return nullptr;
+    }
+    auto ready {std::find_if(m_scheduled.begin(), m_scheduled.end(), [](const std::shared_ptr<PdfFile> &pdfFile) {
+        return pdfFile->isDownloaded();
+    })};
+    if (ready == m_scheduled.end()) {
+        ready = m_scheduled.begin();
+    }
+    std::shared_ptr<PdfFile> pdfFile {std::move(*ready)};
+    m_scheduled.erase(ready);
+    return pdfFile;
+}
+
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
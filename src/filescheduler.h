@@ -0,0 +1,55 @@
+#ifndef FILESCHEDULER_H
+#define FILESCHEDULER_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// local
+#include "pdffile.h"
+
+/*
+    Merges the files of several sources into one processing order.
+    Files wait in a queue per source and are scheduled round robin across the sources,
+    so a source with many files does not hold back the others. Only a few files are
+    scheduled ahead, as many as are downloaded ahead. Of the scheduled files, the next
+    one processed is the first whose download is complete, so a slow server does not
+    stall the processing while the files of another one are ready.
+*/
+class FileScheduler {
+
+public:
+    void add(const std::shared_ptr<PdfFile> &pdfFile);
+    std::shared_ptr<PdfFile> schedule(size_t depth);
+    std::shared_ptr<PdfFile> next();
+
+private:
+    std::mutex m_mutex;
+    // Files not scheduled yet by their source
+    std::map<std::string, std::deque<std::shared_ptr<PdfFile>>> m_waiting;
+    // Source of the last scheduled file, the next file is taken from the source after it
+    std::string m_lastSource;
+    // Files scheduled for processing in their order
+    std::deque<std::shared_ptr<PdfFile>> m_scheduled;
+};
+
+#endif // FILESCHEDULER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -1,4 +1,20 @@
 #include "ftpconnection.h"
+#include "listingsnapshot.h"
+#include "downloadcache.h"
+#include "spoolfile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/time.h>
 
 /**
  * Destructor for the FtpConnection class.
@@ -29,215 +45,1153 @@ FtpConnection::FtpConnection(const ParseUrl &Url) : RemoteHost(Url.Host()),
 }
 
 /**
- * Establishes a connection to the FTP server using SSH protocol.
+ * Borrows an authenticated SFTP session to the server from the SessionPool.
+ *
+ * @return true if a session is available, false if the connection failed.
+ *
+ * @throws None
+ */
+bool FtpConnection::getConnection() {
+    // A session still held from an earlier call is returned first
+    disconnect();
+
+    lease = SessionPool::instance().acquire(RemoteHost, Port, Username, FtpPassword);
+    session = lease.Session();
+    sftp = lease.Sftp();
+    connected = static_cast<bool>(lease);
+    return connected;
+}
+
+/**
+ * Returns the session to the SessionPool, which keeps it open for the next operation.
  *
- * @return void
+ * @param isBroken true if the session failed and must not be reused.
  *
- * @throws std::runtime_error if there is an error during the connection process.
+ * @throws None
  */
-void FtpConnection::getConnection() {
+void FtpConnection::disconnect(bool isBroken) {
+    if (isBroken) {
+        lease.invalidate();
+    }
+    lease.release();
+    sftp = nullptr;
+    session = nullptr;
+    connected = false;
+}
 
-    if (session == NULL) {
-        session = ssh_new();
+/**
+ * Removes files on the server over one session, either deleting them or moving them
+ * into an archive directory, which is created if it is missing. A file whose name is
+ * taken in the archive directory gets the current time appended to its name.
+ *
+ * @param paths The paths of the files on the server of this connection.
+ * @param archiveDirectory The directory relative to the directory of each file or absolute, empty to delete the files.
+ * @param errors Receives the SFTP error code for every path, SSH_FX_OK if the file was removed.
+ *
+ * @return false if the connection failed before all files were handled, the remaining ones have SSH_FX_FAILURE.
+ *
+ * @throws None
+ */
+bool FtpConnection::removeFiles(const std::vector<std::string> &paths, const std::string &archiveDirectory, std::vector<int> &errors) {
+    errors.assign(paths.size(), SSH_FX_FAILURE);
+    if (!getConnection()) {
+        return false;
     }
-    else {  // Reestablish connection
-        if (sftp != nullptr) {
-            sftp_free(sftp);
-            sftp = nullptr;
+
+    std::string createdDirectory;
+    for (size_t i = 0; i < paths.size(); i++) {
+        const std::string &path {paths[i]};
+        int rc {SSH_ERROR};
+        if (archiveDirectory.empty()) {
+            rc = sftp_unlink(sftp, path.c_str());
         }
-        ssh_disconnect(session);
-        ssh_free(session);
-        session = ssh_new();
+        else {
+            const size_t slash {path.rfind('/')};
+            const std::string fileName {path.substr(slash == std::string::npos ? 0 : slash + 1)};
+            std::string target {archiveDirectory};
+            if (target.front() != '/') {
+                target.insert(0, path.substr(0, slash == std::string::npos ? 0 : slash + 1));
+            }
+            if (target.back() != '/') {
+                target += '/';
+            }
+            if (target != createdDirectory) {
+                // Fails harmlessly if the directory exists
+                sftp_mkdir(sftp, target.c_str(), 0755);
+                createdDirectory = target;
+            }
+
+            rc = sftp_rename(sftp, path.c_str(), (target + fileName).c_str());
+            if (rc != SSH_OK && sftp_get_error(sftp) != SSH_FX_NO_SUCH_FILE) {
+                const size_t dot {fileName.rfind('.')};
+                const std::string stamp {"-" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count())};
+                const std::string renamed {dot == std::string::npos ? fileName + stamp : fileName.substr(0, dot) + stamp + fileName.substr(dot)};
+                rc = sftp_rename(sftp, path.c_str(), (target + renamed).c_str());
+            }
+        }
+
+        if (rc == SSH_OK) {
+            errors[i] = SSH_FX_OK;
+            continue;
+        }
+        if (ssh_is_connected(session) == 0) {
+            std::cerr << "Error removing " << path << ": " << ssh_get_error(session) << std::endl;
+            disconnect(true);
+            return false;
+        }
+        errors[i] = sftp_get_error(sftp);
+        std::cerr << "Error removing " << path << ": " << ssh_get_error(session) << std::endl;
     }
+    disconnect();
+    return true;
+}
 
-    ssh_options_set(session, SSH_OPTIONS_HOST, RemoteHost.c_str());
+/**
+ * Returns the directory of the connection with a trailing slash.
+ *
+ * @return The directory path.
+ *
+ * @throws None
+ */
+std::string FtpConnection::basePath() const {
+    return (!Directory.empty() && Directory.back() == '/') ? Directory : Directory + "/";
+}
 
-    if (Port > 0) {
-        ssh_options_set(session, SSH_OPTIONS_PORT, &Port);
+/**
+ * Claims listed files for an instance by moving them into its claim directory below the
+ * directory of the connection, keeping their path relative to it. The rename is atomic on
+ * the server, so of several instances claiming the same file only one succeeds.
+ *
+ * @param instance The name of the instance.
+ * @param files The files to claim, directories are ignored. Receives the claimed files with their new path.
+ *
+ * @return false if the connection failed, the files claimed until then are returned.
+ *
+ * @throws None
+ */
+bool FtpConnection::claimFiles(const std::string &instance, std::vector<remoteFile> &files) {
+    std::vector<remoteFile> claimed;
+    if (!getConnection()) {
+        files.clear();
+        return false;
     }
 
-    Settings settings;
-    ssh_options_set(session, SSH_OPTIONS_IDENTITY, settings.SSHKeyPath().toStdString().c_str());
+    const std::string directoryPath {basePath()};
+    const std::string claimPath {directoryPath + cClaimDirectory + "/" + instance + "/"};
+    // Fail harmlessly if the directories exist
+    sftp_mkdir(sftp, (directoryPath + cClaimDirectory).c_str(), 0755);
+    sftp_mkdir(sftp, claimPath.c_str(), 0755);
+    std::set<std::string> createdDirectories;
 
-    int rc = ssh_connect(session);
+    bool isConnected {true};
+    for (remoteFile &file : files) {
+        if (file.isDirectory || file.path.compare(0, directoryPath.size(), directoryPath) != 0) {
+            continue;
+        }
+        const std::string relativePath {file.path.substr(directoryPath.size())};
+        for (size_t slash = relativePath.find('/'); slash != std::string::npos; slash = relativePath.find('/', slash + 1)) {
+            const std::string subDirectory {claimPath + relativePath.substr(0, slash)};
+            if (createdDirectories.insert(subDirectory).second) {
+                sftp_mkdir(sftp, subDirectory.c_str(), 0755);
+            }
+        }
 
-    if (rc != SSH_OK) {
-        std::cerr << "Error connecting to FTP server: " << ssh_get_error(session) << std::endl;
-        return;
+        const std::string claimedPath {claimPath + relativePath};
+        if (sftp_rename(sftp, file.path.c_str(), claimedPath.c_str()) == SSH_OK) {
+            file.path = claimedPath;
+            claimed.push_back(std::move(file));
+            continue;
+        }
+        if (ssh_is_connected(session) == 0) {
+            std::cerr << "Error claiming " << file.path << ": " << ssh_get_error(session) << std::endl;
+            isConnected = false;
+            break;
+        }
+        if (sftp_get_error(sftp) == SSH_FX_NO_SUCH_FILE) {
+            #ifdef DEBUG
+                std::cout << "FtpConnection::claimFiles: " << file.path << " was claimed by another instance" << std::endl;
+            #endif
+        }
+        else {
+            std::cerr << "Error claiming " << file.path << ": " << ssh_get_error(session) << std::endl;
+        }
+    }
+    if (isConnected && !claimed.empty()) {
+        // The claim directory counts as alive from now on
+        probeDirectory(claimPath + cHeartbeatProbe);
     }
+    disconnect(!isConnected);
+    files = std::move(claimed);
+    return isConnected;
+}
 
-    // Verify the server's host key
-    ssh_key server_pubkey;
-    rc = ssh_get_server_publickey(session, &server_pubkey);
-    if (rc == SSH_OK) {
-        ssh_key_free(server_pubkey);
-    } else {
-        std::cerr << "Server's host key is not known." << std::endl;
-        return;
+/**
+ * Moves the files of orphaned claims back into the directory of the connection and
+ * removes the claim directories. The recovered files get the current modification
+ * time, so incremental listings offer them again.
+ * The age of a claim is measured with the server's clock, which also stamps the heartbeats,
+ * so the clocks of the instances do not have to agree.
+ *
+ * @param instance The name of the recovering instance, it names the probe of the server's clock.
+ * @param isOrphaned Called with the name of every other instance and the seconds since it touched its
+ *                   claim directory, 0 if the server's clock could not be read.
+ *
+ * @return false if the connection failed.
+ *
+ * @throws None
+ */
+bool FtpConnection::recoverClaims(const std::string &instance, const std::function<bool(const std::string &, int64_t)> &isOrphaned) {
+    if (!getConnection()) {
+        return false;
     }
 
-    // First try to authenticate with the server using ssh-keys
-    rc = ssh_userauth_publickey_auto(session, NULL, settings.SSHKeyPath().toStdString().c_str());
-    if (rc != SSH_AUTH_SUCCESS) {
-        // Authentication using keys failed, try user/password
-        rc = ssh_userauth_password(session, NULL, FtpPassword.c_str());
-        if (rc != SSH_AUTH_SUCCESS) {
-            // Also user/password authentication failed, give up
-            std::cerr << "Error connecting to FTP server: " << ssh_get_error(session) << std::endl;
-            return;
-        } 
+    const std::string claimRoot {basePath() + cClaimDirectory + "/"};
+    sftp_dir dir = sftp_opendir(sftp, claimRoot.c_str());
+    if (dir == NULL) {
+        // Nothing was claimed yet
+        disconnect();
+        return true;
+    }
+    // The probe is a file, it is not taken for a claim directory
+    int64_t serverTime {0};
+    const bool isTimeKnown {probeDirectory(claimRoot + "." + instance + cClockProbe, &serverTime)};
+    if (!isTimeKnown) {
+        std::cerr << "Could not read the clock of " << RemoteHost << ", only claims of ended processes on this host are recovered" << std::endl;
     }
 
-    // Open an SFTP session
-    sftp = sftp_new(session);
-    rc = sftp_init(sftp);
-    if (rc != SSH_OK) {
-        std::cerr << "Error initializing SFTP session: " << ssh_get_error(session) << std::endl;
-        return;
+    std::vector<std::string> orphans;
+    sftp_attributes attributes;
+    while ((attributes = sftp_readdir(sftp, dir)) != NULL) {
+        const std::string name {attributes->name};
+        const int64_t age {isTimeKnown ? serverTime - static_cast<int64_t>(attributes->mtime) : 0};
+        if (name != "." && name != ".." && attributes->type == SSH_FILEXFER_TYPE_DIRECTORY && isOrphaned(name, age)) {
+            orphans.push_back(name);
+        }
+        sftp_attributes_free(attributes);
     }
-    else {
-        connected = true;
+    sftp_closedir(dir);
+
+    for (const std::string &orphan : orphans) {
+        // Left behind if the instance ended while touching its claims
+        sftp_unlink(sftp, (claimRoot + orphan + "/" + cHeartbeatProbe).c_str());
+        const size_t count {recoverDirectory(claimRoot + orphan + "/", basePath())};
+        sftp_rmdir(sftp, (claimRoot + orphan).c_str());
+        std::cerr << "Recovered " << count << " files claimed by " << orphan << " in " << Directory << std::endl;
     }
+
+    const bool isConnected {ssh_is_connected(session) != 0};
+    disconnect(!isConnected);
+    return isConnected;
 }
+
 /**
- * Disconnects from the FTP server and frees associated resources.
+ * Moves the files of a claimed directory and its subdirectories back, removing the
+ * emptied subdirectories. A file whose name was taken in the meantime is left claimed.
+ *
+ * @param claimedDirectory The claimed directory with a trailing slash.
+ * @param directory The directory the files are moved to with a trailing slash.
  *
- * This function releases the SFTP session and the SSH session, and sets their
- * respective pointers to null. 
+ * @return The number of recovered files.
  *
  * @throws None
  */
-void FtpConnection::disconnect() {
-    sftp_free(sftp);
-    sftp = nullptr;
-    ssh_disconnect(session);
-    ssh_free(session);
-    session = nullptr;
+size_t FtpConnection::recoverDirectory(const std::string &claimedDirectory, const std::string &directory) {
+    sftp_dir dir = sftp_opendir(sftp, claimedDirectory.c_str());
+    if (dir == NULL) {
+        return 0;
+    }
+    std::vector<std::string> fileNames;
+    std::vector<std::string> subDirectories;
+    sftp_attributes attributes;
+    while ((attributes = sftp_readdir(sftp, dir)) != NULL) {
+        const std::string fileName {attributes->name};
+        if (attributes->type == SSH_FILEXFER_TYPE_REGULAR) {
+            fileNames.push_back(fileName);
+        }
+        else if (attributes->type == SSH_FILEXFER_TYPE_DIRECTORY && fileName != "." && fileName != "..") {
+            subDirectories.push_back(fileName);
+        }
+        sftp_attributes_free(attributes);
+    }
+    sftp_closedir(dir);
+
+    size_t count {0};
+    for (const std::string &fileName : fileNames) {
+        const std::string path {directory + fileName};
+        if (sftp_rename(sftp, (claimedDirectory + fileName).c_str(), path.c_str()) == SSH_OK) {
+            struct timeval times[2];
+            gettimeofday(&times[0], nullptr);
+            times[1] = times[0];
+            sftp_utimes(sftp, path.c_str(), times);
+            count++;
+        }
+    }
+    for (const std::string &subDirectory : subDirectories) {
+        count += recoverDirectory(claimedDirectory + subDirectory + "/", directory + subDirectory + "/");
+        sftp_rmdir(sftp, (claimedDirectory + subDirectory).c_str());
+    }
+    return count;
 }
 
 /**
- * Deletes a file on the FTP server.
+ * Updates the modification time of the claim directory of an instance, showing the other
+ * instances that its claims are alive. The server sets the time when the probe is created
+ * and removed, so it is always the server's clock.
+ *
+ * @param instance The name of the instance.
  *
- * @return true if the file was successfully deleted, false otherwise
+ * @return false if the connection failed.
  *
  * @throws None
  */
-bool FtpConnection::deleteFile() {
-    getConnection();
+bool FtpConnection::touchClaims(const std::string &instance) {
+    if (!getConnection()) {
+        return false;
+    }
+    probeDirectory(basePath() + cClaimDirectory + "/" + instance + "/" + cHeartbeatProbe);
 
-    std::string urlString = Directory + "/" + Filename;
-    const char *cUrl = urlString.c_str();
+    const bool isConnected {ssh_is_connected(session) != 0};
+    disconnect(!isConnected);
+    return isConnected;
+}
 
-    sftp_file file = sftp_open(sftp, cUrl, O_WRONLY, 0);
-    if (file == NULL) {
-        std::cerr << "Error opening file: " << ssh_get_error(session) << std::endl;
+/**
+ * Creates and removes an empty file, the server sets the modification time of its directory
+ * to the server's current time.
+ *
+ * @param probePath The path of the file, it must not be used otherwise.
+ * @param serverTime Receives the server's current time if not nullptr.
+ *
+ * @return true if the file was created and, if requested, the time was read.
+ *
+ * @throws None
+ */
+bool FtpConnection::probeDirectory(const std::string &probePath, int64_t *serverTime) {
+    sftp_file probe = sftp_open(sftp, probePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (probe == NULL) {
         return false;
-        disconnect();
     }
+    bool isProbed {true};
+    if (serverTime != nullptr) {
+        sftp_attributes attributes = sftp_fstat(probe);
+        isProbed = (attributes != NULL);
+        if (isProbed) {
+            *serverTime = static_cast<int64_t>(attributes->mtime);
+            sftp_attributes_free(attributes);
+        }
+    }
+    sftp_close(probe);
+    sftp_unlink(sftp, probePath.c_str());
+    return isProbed;
+}
 
-    int rc = sftp_unlink(sftp, cUrl);
-    sftp_close(file);
-    if (rc != SSH_OK) {
-        std::cerr << "Error deleting file: " << ssh_get_error(session) << std::endl;
-        disconnect();
-        return false;
+/**
+ * Returns the path a claimed file had before it was claimed.
+ *
+ * @param path The path of a file or directory, claimed or not.
+ *
+ * @return The path without the claim directory and instance, the path itself if it is not claimed.
+ *
+ * @throws None
+ */
+std::string FtpConnection::unclaimedPath(const std::string &path) {
+    const std::string claimDirectory {std::string("/") + cClaimDirectory + "/"};
+    const size_t claimStart {path.find(claimDirectory)};
+    if (claimStart == std::string::npos) {
+        return path;
     }
-    disconnect();
-    return true;
+    const size_t instanceEnd {path.find('/', claimStart + claimDirectory.size())};
+    if (instanceEnd == std::string::npos) {
+        return path;
+    }
+    return path.substr(0, claimStart + 1) + path.substr(instanceEnd + 1);
 }
 
 /**
  * Retrieves a file from the FTP server and returns its contents as a unique pointer to a string.
+ * The file is downloaded with many read requests in flight, so the transfer is limited by
+ * the bandwidth of the link instead of its round trip time.
+ * The received bytes are spooled to disk, an interrupted download is resumed where it
+ * stopped after a delay growing with every attempt.
+ *
+ * @param received Called with the number of bytes of every reply, may delay the download to limit its bandwidth.
  *
  * @return A unique pointer to a string containing the file contents, or nullptr if an error occurs.
  *
  * @throws None
  */
-std::unique_ptr<std::string> FtpConnection::getFilePtr() {
-    getConnection();
+std::unique_ptr<std::string> FtpConnection::getFilePtr(const std::function<void(size_t)> &received) {
+    const auto startTime {std::chrono::steady_clock::now()};
+    std::unique_ptr<std::string> data {std::make_unique<std::string>()};
+    std::unique_ptr<SpoolFile> spool;
+    bool isResumed {false};
+
+    downloadResult result {downloadResult::interrupted};
+    for (int attempt = 0; attempt < cMaxAttempts && result == downloadResult::interrupted; attempt++) {
+        if (attempt > 0) {
+            const std::chrono::seconds delay {std::min(cRetryDelay * (1 << (attempt - 1)), cMaxRetryDelay)};
+            std::cerr << "Download of " << Filename << " interrupted at " << (spool != nullptr ? spool->Size() : 0)
+                      << " bytes, retrying in " << delay.count() << " s" << std::endl;
+            std::this_thread::sleep_for(delay);
+        }
+        result = download(spool, *data, isResumed, received);
+    }
+    if (result != downloadResult::complete) {
+        return nullptr;
+    }
 
-    sftp_file remoteFile = sftp_open(sftp, (Directory + "/" + Filename).c_str(), O_RDONLY, 0);
+    #ifdef DEBUG
+        const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()};
+        std::cout << "FtpConnection::getFilePtr: " << Filename << ": " << data->size() << " bytes in " << seconds << " s, "
+                  << ((seconds > 0.0) ? data->size() / seconds / (1024 * 1024) : 0.0) << " MB/s" << std::endl;
+    #endif
+    return data;
+}
+
+/**
+ * One attempt to download the file, continuing after the bytes in the spool file if it
+ * belongs to the same version of the file.
+ *
+ * @param spool The spool file of the download, created at the first attempt.
+ * @param data Receives the file contents.
+ * @param isResumed Set if the download continued the content of an earlier attempt.
+ * @param received Called with the number of bytes of every reply.
+ *
+ * @return complete if the file was read, interrupted if another attempt may succeed, failed otherwise.
+ *
+ * @throws None
+ */
+FtpConnection::downloadResult FtpConnection::download(std::unique_ptr<SpoolFile> &spool, std::string &data, bool &isResumed,
+                                                      const std::function<void(size_t)> &received) {
+    if (!getConnection()) {
+        return downloadResult::interrupted;
+    }
+
+    const std::string host {Username + "@" + RemoteHost + ":" + std::to_string(Port)};
+    const std::string path {Directory + "/" + Filename};
+    sftp_file remoteFile = sftp_open(sftp, path.c_str(), O_RDONLY, 0);
     if (remoteFile == NULL) {
         std::cerr << "Error opening file: " << ssh_get_error(session) << std::endl;
-        return nullptr;
+        const int error {sftp_get_error(sftp)};
+        if (error == SSH_FX_NO_SUCH_FILE || error == SSH_FX_PERMISSION_DENIED) {
+            disconnect();
+            return downloadResult::failed;
+        }
+        disconnect(true);
+        return downloadResult::interrupted;
     }
 
-    // Read the remote file and write to memory object
-    char buffer[1024];
-    ssize_t nbytes;
+    // The size is only a hint to presize the buffer, the file is read until its end
+    uint64_t fileSize {0};
+    int64_t mtime {0};
+    sftp_attributes attributes {sftp_fstat(remoteFile)};
+    if (attributes != nullptr) {
+        fileSize = attributes->size;
+        mtime = attributes->mtime;
+        sftp_attributes_free(attributes);
 
-    std::string ss;
-    while ((nbytes = sftp_read(remoteFile, buffer, sizeof(buffer))) > 0) {
-        ss.append(buffer, nbytes);
+        // A new version of the file starts over, the spool file of an earlier one is left to expire
+        const std::string keyHash {DownloadCache::keyHash(host, path, fileSize, mtime)};
+        if (spool == nullptr || spool->KeyHash() != keyHash) {
+            // A file opened before is only downloaded again if it changed
+            std::unique_ptr<std::string> cached {DownloadCache::instance().get(host, path, fileSize, mtime)};
+            if (cached != nullptr) {
+                sftp_close(remoteFile);
+                disconnect();
+                data = std::move(*cached);
+                return downloadResult::complete;
+            }
+            data.resize(fileSize);
+            spool = std::make_unique<SpoolFile>(keyHash);
+            spool->load(data.data(), fileSize);
+        }
+    }
+    else {
+        spool.reset();
+    }
+
+    // Bytes received by an earlier attempt are kept
+    data.resize(fileSize);
+    const uint64_t startOffset {(spool != nullptr) ? spool->Size() : 0};
+    isResumed = isResumed || startOffset > 0;
+    bool isEndOfFile {false};
+    bool isRead {sftp_seek64(remoteFile, startOffset) >= 0
+                 && readPipelined(remoteFile, startOffset, fileSize, data, isEndOfFile, received, spool.get())};
+
+    // Data appended after the size was taken, or all of it if the size is unknown
+    if (isRead && !isEndOfFile) {
+        std::vector<char> buffer(readChunkSize());
+        ssize_t nbytes {sftp_seek64(remoteFile, data.size())};
+        while (nbytes >= 0 && (nbytes = sftp_read(remoteFile, buffer.data(), buffer.size())) > 0) {
+            data.append(buffer.data(), nbytes);
+            if (spool != nullptr) {
+                spool->append(buffer.data(), nbytes);
+            }
+            if (received) {
+                received(nbytes);
+            }
+        }
+        isRead = (nbytes == 0);
     }
 
     // Check for errors
-    if (nbytes < 0) {
+    if (!isRead) {
         std::cerr << "Error reading file: " << ssh_get_error(session) << std::endl;
-        disconnect();
-        return nullptr;
+        sftp_close(remoteFile);
+        disconnect(true);
+        return downloadResult::interrupted;
     }
 
     // Close the file
     int rc = sftp_close(remoteFile);
     if (rc != SSH_OK) {
         std::cerr << "Error closing file: " << ssh_get_error(session) << std::endl;
-        disconnect();
-        return nullptr;
+        disconnect(true);
+        return downloadResult::interrupted;
+    }
+
+    if (spool != nullptr) {
+        // Bytes from different attempts belong together if the server has the same checksum, if it can tell
+        const std::string checksum {spool->checksum()};
+        if (isResumed) {
+            const std::string serverChecksum {remoteChecksum(path)};
+            if (!serverChecksum.empty() && serverChecksum != checksum) {
+                std::cerr << "Checksum mismatch of resumed download " << Filename << ", starting over" << std::endl;
+                spool->restart();
+                isResumed = false;
+                disconnect();
+                return downloadResult::interrupted;
+            }
+        }
+        spool->remove();
+        // Cached under the size and time the file was opened with, a file that grew meanwhile is not cached
+        DownloadCache::instance().put(host, path, fileSize, mtime, data, checksum);
     }
     disconnect();
-    return std::make_unique<std::string>(std::move(ss));
+    return downloadResult::complete;
 }
 
 /**
- * Retrieves the list of files in the remote directory.
+ * Returns the size of a single read request, the largest the server accepts up to cMaxReadChunk.
  *
- * @param isRecursive Flag indicating whether to recursively search subdirectories.
+ * @return The read request size in bytes.
+ *
+ * @throws None
+ */
+uint32_t FtpConnection::readChunkSize() const {
+    uint32_t chunkSize {cDefaultReadChunk};
+    #if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        sftp_limits_t limits {sftp_limits(sftp)};
+        if (limits != nullptr) {
+            if (limits->max_read_length > cDefaultReadChunk) {
+                chunkSize = static_cast<uint32_t>(std::min<uint64_t>(limits->max_read_length, cMaxReadChunk));
+            }
+            sftp_limits_free(limits);
+        }
+    #endif
+    return chunkSize;
+}
+
+/**
+ * Reads the file up to its expected size with a window of read requests in flight.
+ * Every reply is stored at its offset in the presized buffer, short replies are requested again.
+ * Whenever the bytes up to an offset are complete, they are appended to the spool file.
+ *
+ * @param remoteFile The opened remote file, its offset is at startOffset.
+ * @param startOffset The offset to start reading at, the bytes before are already in data.
+ * @param fileSize The size of the file when it was opened.
+ * @param data Receives the file content, resized to the number of bytes read.
+ * @param isEndOfFile Set if the server reported the end of the file before fileSize.
+ * @param received Called with the number of bytes of every reply, may be empty.
+ * @param spool The spool file holding the bytes up to startOffset, may be nullptr.
  *
- * @return A unique pointer to a vector of strings containing the file paths.
+ * @return true on success, false if a read request failed.
  *
  * @throws None
  */
-std::unique_ptr<std::vector<std::string>> FtpConnection::getRemoteDir(bool isRecursive) {
-    std::unique_ptr<std::vector<std::string>> files = std::make_unique<std::vector<std::string>>();
-    sftp_dir dir;
-    getConnection();
+bool FtpConnection::readPipelined(sftp_file remoteFile, uint64_t startOffset, uint64_t fileSize, std::string &data, bool &isEndOfFile,
+                                  const std::function<void(size_t)> &received, SpoolFile *spool) const {
+    const uint32_t chunkSize {readChunkSize()};
+    const size_t maxRequests {std::max(cReadWindow / chunkSize, cMinReadRequests)};
 
-    // Open base directory
-    dir = sftp_opendir(sftp, Directory.c_str());
+    data.resize(fileSize);
+    std::deque<readRequest> requests;
+    uint64_t nextOffset {startOffset};
+    uint64_t endOffset {fileSize};
+    bool isFailed {false};
 
-    if (dir == NULL) {
+    // Spools the bytes before the lowest offset still requested
+    auto spoolComplete = [&]() {
+        if (spool == nullptr) {
+            return;
+        }
+        uint64_t completeOffset {std::min(nextOffset, endOffset)};
+        for (const readRequest &request : requests) {
+            completeOffset = std::min(completeOffset, request.offset);
+        }
+        if (completeOffset > spool->Size()) {
+            spool->append(data.data() + spool->Size(), completeOffset - spool->Size());
+        }
+    };
+
+    while (!isFailed) {
+        // Keep the window full
+        while (nextOffset < endOffset && requests.size() < maxRequests) {
+            readRequest request;
+            request.offset = nextOffset;
+            request.length = static_cast<uint32_t>(std::min<uint64_t>(chunkSize, endOffset - nextOffset));
+            if (!beginRead(remoteFile, request)) {
+                isFailed = true;
+                break;
+            }
+            requests.push_back(request);
+            nextOffset += request.length;
+        }
+        if (isFailed || requests.empty()) {
+            break;
+        }
+
+        readRequest request {requests.front()};
+        requests.pop_front();
+        const ssize_t nbytes {waitRead(remoteFile, request, data.data() + request.offset)};
+        if (nbytes > 0 && received) {
+            received(nbytes);
+        }
+
+        if (nbytes < 0) {
+            isFailed = true;
+        }
+        else if (nbytes == 0) {
+            // The file got shorter since it was opened
+            endOffset = std::min(endOffset, request.offset);
+            isEndOfFile = true;
+        }
+        else if (nbytes < request.length && request.offset + nbytes < endOffset) {
+            // The server may return less than requested, the rest is requested again
+            readRequest rest;
+            rest.offset = request.offset + nbytes;
+            rest.length = request.length - static_cast<uint32_t>(nbytes);
+            if (sftp_seek64(remoteFile, rest.offset) < 0 || !beginRead(remoteFile, rest)) {
+                isFailed = true;
+                break;
+            }
+            requests.push_back(rest);
+            if (sftp_seek64(remoteFile, nextOffset) < 0) {
+                isFailed = true;
+            }
+        }
+        if (!isFailed) {
+            spoolComplete();
+        }
+    }
+
+    // Requests still in flight after an error are abandoned, the session is not reused
+    for (readRequest &request : requests) {
+        cancelRead(request);
+    }
+    if (isFailed) {
+        return false;
+    }
+    data.resize(std::min<uint64_t>(endOffset, data.size()));
+    return true;
+}
+
+/**
+ * Sends a read request for request.length bytes at the current offset of the file,
+ * which is advanced by the requested length.
+ *
+ * @param remoteFile The remote file.
+ * @param request The request, receives the handle of the outstanding read.
+ *
+ * @return true if the request was sent.
+ *
+ * @throws None
+ */
+bool FtpConnection::beginRead(sftp_file remoteFile, readRequest &request) {
+    #if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        return sftp_aio_begin_read(remoteFile, request.length, &request.aio) != SSH_ERROR;
+    #else
+        request.id = sftp_async_read_begin(remoteFile, request.length);
+        return request.id >= 0;
+    #endif
+}
+
+/**
+ * Waits for the reply of a read request.
+ *
+ * @param remoteFile The remote file.
+ * @param request The outstanding request, its handle is released.
+ * @param buffer Receives up to request.length bytes.
+ *
+ * @return The number of bytes received, 0 at the end of the file, negative on error.
+ *
+ * @throws None
+ */
+ssize_t FtpConnection::waitRead(sftp_file remoteFile, readRequest &request, char *buffer) {
+    #if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        (void)remoteFile;
+        return sftp_aio_wait_read(&request.aio, buffer, request.length);
+    #else
+        ssize_t nbytes;
+        do {
+            nbytes = sftp_async_read(remoteFile, buffer, request.length, request.id);
+        } while (nbytes == SSH_AGAIN);
+        return nbytes;
+    #endif
+}
+
+/**
+ * Releases an outstanding read request without waiting for its reply.
+ *
+ * @param request The outstanding request.
+ *
+ * @throws None
+ */
+void FtpConnection::cancelRead(readRequest &request) {
+    #if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        sftp_aio_free(request.aio);
+        request.aio = nullptr;
+    #else
+        // The reply is discarded together with the session
+        (void)request;
+    #endif
+}
+
+/**
+ * Retrieves the list of pdf files and directories in the remote directory, sorted by path.
+ * With isRemoteFind the server lists the whole tree with one find command over an ssh exec
+ * channel, which takes one round trip instead of one per directory. If the server has no
+ * shell or no GNU find, the directory is browsed with SFTP.
+ *
+ * @param isRecursive Flag indicating whether to recursively search subdirectories.
+ * @param isRemoteFind Flag indicating whether to list the directory with find on the server.
+ * @param snapshot The listing of the previous scan, unchanged directories are not read again with SFTP. May be nullptr.
+ *
+ * @return A unique pointer to a vector of the files and directories found, directory paths end with a slash.
+ *         nullptr if the directory can not be read.
+ *
+ * @throws None
+ */
+std::unique_ptr<std::vector<FtpConnection::remoteFile>> FtpConnection::getRemoteDir(bool isRecursive, bool isRemoteFind,
+                                                                                     const ListingSnapshot *snapshot) {
+    std::unique_ptr<std::vector<remoteFile>> files = std::make_unique<std::vector<remoteFile>>();
+    if (!getConnection()) {
+        return nullptr;
+    }
+
+    const std::string directoryPath {basePath()};
+    sftp_attributes attributes = sftp_stat(sftp, directoryPath.c_str());
+    if (attributes == NULL || attributes->type != SSH_FILEXFER_TYPE_DIRECTORY) {
         std::cerr << "Base directory not found: " << Directory << "\nError: " << ssh_get_error(session) << std::endl;
+        if (attributes != NULL) {
+            sftp_attributes_free(attributes);
+        }
         disconnect();
         return nullptr;
     }
+    const pendingDirectory base {directoryPath, static_cast<int64_t>(attributes->mtime), true};
+    sftp_attributes_free(attributes);
 
-    // lambda function to loop through subdirectories if recursive and add all pdf files
-    std::function<void(const std::string&)> readDirectory = [&](const std::string& subDirectory) {
-        sftp_dir subdir = sftp_opendir(sftp, subDirectory.c_str());
-        if (subdir == NULL) {
-            return;
+    const auto startTime {std::chrono::steady_clock::now()};
+    bool isFound {false};
+    if (isRemoteFind) {
+        isFound = listWithFind(base.path, isRecursive, *files);
+        if (!isFound) {
+            std::cerr << "Listing " << base.path << " with find failed, browsing it with SFTP" << std::endl;
+            files->clear();
         }
+    }
+    if (!isFound) {
+        listWithSftp(base, isRecursive, snapshot, *files);
+    }
+    disconnect();
 
-        sftp_attributes attributes;
-        while ((attributes = sftp_readdir(sftp, subdir)) != NULL) {
-            std::string fileName = attributes->name;
+    #ifdef DEBUG
+        std::cout << "FtpConnection::getRemoteDir: " << files->size() << " files in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() << " s" << std::endl;
+    #endif
 
-            if (fileName == "." || fileName == "..") {
-                continue;
-            } else if (fileName.substr(fileName.length() - 3, 3) == "pdf") {
-                files->push_back(subDirectory + fileName);
-            } else if (attributes->permissions & S_IFDIR && isRecursive) {
-                readDirectory(subDirectory + fileName);
+    std::sort(files->begin(), files->end(), [](const remoteFile &a, const remoteFile &b) {
+        return a.path < b.path;
+    });
+    return files;
+}
+
+/**
+ * Executes a command on the server over an ssh exec channel.
+ *
+ * @param command The command, run by the shell of the user.
+ * @param output Called with every block of the standard output while it streams in.
+ * @param exitStatus Receives the exit status of the command.
+ *
+ * @return true if the command ran and its output was read completely.
+ *
+ * @throws None
+ */
+bool FtpConnection::execCommand(const std::string &command, const std::function<void(const char *, size_t)> &output, int &exitStatus) {
+    ssh_channel channel = ssh_channel_new(session);
+    if (channel == nullptr) {
+        return false;
+    }
+    if (ssh_channel_open_session(channel) != SSH_OK) {
+        ssh_channel_free(channel);
+        return false;
+    }
+    if (ssh_channel_request_exec(channel, command.c_str()) != SSH_OK) {
+        ssh_channel_close(channel);
+        ssh_channel_free(channel);
+        return false;
+    }
+
+    std::vector<char> buffer(cExecReadBuffer);
+    int bytes;
+    while ((bytes = ssh_channel_read(channel, buffer.data(), buffer.size(), 0)) > 0) {
+        output(buffer.data(), bytes);
+    }
+
+    const bool isRead {bytes == 0};
+    exitStatus = isRead ? ssh_channel_get_exit_status(channel) : -1;
+    ssh_channel_close(channel);
+    ssh_channel_free(channel);
+    return isRead;
+}
+
+/**
+ * Asks the server for the checksum of a file.
+ *
+ * @param path The path of the file.
+ *
+ * @return The SHA-256 of the file as hex string, empty if the server has no shell or no sha256sum.
+ *
+ * @throws None
+ */
+std::string FtpConnection::remoteChecksum(const std::string &path) {
+    std::string output;
+    int exitStatus {-1};
+    const bool isRun {execCommand("sha256sum -b -- " + shellQuote(path) + " 2>/dev/null", [&output](const char *data, size_t size) {
+        output.append(data, size);
+    }, exitStatus)};
+
+    // The output is the checksum followed by the file name
+    static constexpr size_t cChecksumLength = 64;
+    if (!isRun || exitStatus != 0 || output.size() < cChecksumLength
+        || output.find_first_not_of("0123456789abcdef") < cChecksumLength) {
+        return std::string();
+    }
+    return output.substr(0, cChecksumLength);
+}
+
+/**
+ * Lists the pdf files and directories with a find command executed on the server. The records are
+ * separated by NUL characters, so any file name is transferred unchanged, and parsed
+ * while the output streams in.
+ *
+ * @param baseDirectory The directory to list, ending with a slash.
+ * @param isRecursive Flag indicating whether to recursively search subdirectories.
+ * @param files The files found are appended.
+ *
+ * @return true if find ran on the server, false if the listing has to be done with SFTP.
+ *
+ * @throws None
+ */
+bool FtpConnection::listWithFind(const std::string &baseDirectory, bool isRecursive, std::vector<remoteFile> &files) {
+    // %y type, %s size, %T@ modification time in seconds, %P path below the base directory.
+    // Unreadable subdirectories are skipped like with SFTP, their messages are discarded.
+    // Files claimed by instances are left out.
+    const std::string command {"find " + shellQuote(baseDirectory) + (isRecursive ? "" : " -maxdepth 1")
+                               + " -name " + shellQuote(cClaimDirectory) + " -prune -o"
+                               + " \\( -type d -o -type f -iname '*.pdf' \\) -printf '%y\\t%s\\t%T@\\t%P\\0' 2>/dev/null"};
+
+    std::string pending;
+    int exitStatus {-1};
+    const bool isRead {execCommand(command, [&](const char *data, size_t size) {
+        pending.append(data, size);
+        size_t start {0};
+        size_t end;
+        while ((end = pending.find('\0', start)) != std::string::npos) {
+            remoteFile file;
+            if (parseFindRecord(pending.substr(start, end - start), baseDirectory, file)) {
+                files.push_back(std::move(file));
             }
+            start = end + 1;
         }
+        pending.erase(0, start);
+    }, exitStatus)};
+
+    #ifdef DEBUG
+        std::cout << "FtpConnection::listWithFind: exit status " << exitStatus << ", " << files.size() << " files" << std::endl;
+    #endif
+
+    // find exits with 1 if a subdirectory was unreadable, but then it listed the others.
+    // Without output, find or -printf may be missing on the server.
+    return isRead && (exitStatus == 0 || !files.empty());
+}
 
-        sftp_closedir(subdir);
+/**
+ * Parses one record of the find output.
+ *
+ * @param record The record "type<TAB>size<TAB>mtime<TAB>path" without its NUL terminator.
+ * @param baseDirectory The listed directory the path is relative to.
+ * @param file Receives the file.
+ *
+ * @return true if the record is a pdf file or a directory.
+ *
+ * @throws None
+ */
+bool FtpConnection::parseFindRecord(const std::string &record, const std::string &baseDirectory, remoteFile &file) {
+    const size_t sizeStart {record.find('\t')};
+    const size_t mtimeStart {(sizeStart != std::string::npos) ? record.find('\t', sizeStart + 1) : std::string::npos};
+    const size_t pathStart {(mtimeStart != std::string::npos) ? record.find('\t', mtimeStart + 1) : std::string::npos};
+    if (pathStart == std::string::npos) {
+        return false;
+    }
+    const std::string path {record.substr(pathStart + 1)};
+    file.isDirectory = (record.compare(0, sizeStart, "d") == 0);
+    if (file.isDirectory) {
+        // The base directory itself has an empty path
+        file.path = path.empty() ? baseDirectory : baseDirectory + path + "/";
+    }
+    else if (record.compare(0, sizeStart, "f") == 0 && isPdf(path)) {
+        file.path = baseDirectory + path;
+    }
+    else {
+        return false;
+    }
+
+    // Like with SFTP, directories are listed without size
+    file.size = file.isDirectory ? 0 : std::strtoull(record.c_str() + sizeStart + 1, nullptr, 10);
+    // The fraction of a second is not needed
+    file.mtime = std::strtoll(record.c_str() + mtimeStart + 1, nullptr, 10);
+    return true;
+}
+
+/**
+ * Lists the pdf files and directories by browsing the directory with SFTP, breadth first.
+ * Subdirectories are read on up to cListingConnections sessions at the same time, as
+ * libssh waits for the reply of every opendir and readdir.
+ *
+ * @param baseDirectory The directory to list, ending with a slash.
+ * @param isRecursive Flag indicating whether to recursively search subdirectories.
+ * @param snapshot The listing of the previous scan, may be nullptr.
+ * @param files The files and directories found are appended.
+ *
+ * @throws None
+ */
+void FtpConnection::listWithSftp(const pendingDirectory &baseDirectory, bool isRecursive, const ListingSnapshot *snapshot,
+                                 std::vector<remoteFile> &files) {
+    std::vector<pendingDirectory> subDirectories;
+    visitDirectory(sftp, baseDirectory, isRecursive, snapshot, files, subDirectories);
+    if (subDirectories.empty()) {
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<pendingDirectory> directories(subDirectories.begin(), subDirectories.end());
+    size_t busy {0};
+
+    // Takes directories from the queue until it is empty and no other worker can add more
+    auto work = [&](sftp_session workerSftp) {
+        std::vector<remoteFile> found;
+        std::vector<pendingDirectory> foundDirectories;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return !directories.empty() || busy == 0; });
+            if (directories.empty()) {
+                return;
+            }
+            const pendingDirectory directory {std::move(directories.front())};
+            directories.pop_front();
+            busy++;
+            lock.unlock();
+
+            found.clear();
+            foundDirectories.clear();
+            visitDirectory(workerSftp, directory, isRecursive, snapshot, found, foundDirectories);
+
+            lock.lock();
+            files.insert(files.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+            directories.insert(directories.end(), std::make_move_iterator(foundDirectories.begin()), std::make_move_iterator(foundDirectories.end()));
+            busy--;
+            changed.notify_all();
+        }
     };
-    // Start traversal from the base directory
-    readDirectory(Directory);
+
+    // The helpers borrow sessions of their own if the SessionPool has them to spare right away,
+    // waiting for one could deadlock when the callers of the pool hold all sessions of the host
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < std::min(cListingConnections, subDirectories.size()); i++) {
+        helpers.emplace_back([&] {
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                if (directories.empty() && busy == 0) {
+                    return;
+                }
+            }
+            SessionPool::Lease helperLease {SessionPool::instance().tryAcquire(RemoteHost, Port, Username, FtpPassword)};
+            if (helperLease) {
+                work(helperLease.Sftp());
+            }
+        });
+    }
+    work(sftp);
     disconnect();
-    return std::move(files);
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+}
+
+/**
+ * Lists one directory. If the snapshot has the directory with the same modification time,
+ * its entries are taken from the snapshot and only its subdirectories are visited.
+ * Files rewritten in place do not change the directory's modification time, so the files
+ * of an unchanged directory are checked one by one. A directory with more files is read again,
+ * which takes fewer round trips than checking them.
+ *
+ * @param sftp The SFTP session.
+ * @param directory The directory.
+ * @param isRecursive Flag indicating whether subdirectories are returned.
+ * @param snapshot The listing of the previous scan, may be nullptr.
+ * @param files The directory and its pdf files are appended.
+ * @param subDirectories The subdirectories are appended.
+ *
+ * @throws None
+ */
+void FtpConnection::visitDirectory(sftp_session sftp, const pendingDirectory &directory, bool isRecursive, const ListingSnapshot *snapshot,
+                                   std::vector<remoteFile> &files, std::vector<pendingDirectory> &subDirectories) {
+    int64_t mtime {directory.mtime};
+    if (!directory.isMtimeKnown) {
+        sftp_attributes attributes = sftp_stat(sftp, directory.path.c_str());
+        if (attributes == NULL) {
+            return;
+        }
+        mtime = attributes->mtime;
+        sftp_attributes_free(attributes);
+    }
+
+    std::vector<remoteFile> knownFiles;
+    std::vector<std::string> knownDirectories;
+    bool isKnown {false};
+    if (snapshot != nullptr && snapshot->isUnchanged(directory.path, mtime)) {
+        snapshot->children(directory.path, knownFiles, knownDirectories);
+        isKnown = (knownFiles.size() <= cMaxCheckedFiles && updateFiles(sftp, knownFiles));
+    }
+
+    if (isKnown) {
+        files.insert(files.end(), std::make_move_iterator(knownFiles.begin()), std::make_move_iterator(knownFiles.end()));
+        if (isRecursive) {
+            for (std::string &knownDirectory : knownDirectories) {
+                subDirectories.push_back({std::move(knownDirectory)});
+            }
+        }
+    }
+    else if (!readDirectory(sftp, directory.path, isRecursive, files, subDirectories)) {
+        return;
+    }
+    files.push_back({directory.path, 0, mtime, true});
+}
+
+/**
+ * Replaces size and modification time of files with their current values.
+ *
+ * @param sftp The SFTP session.
+ * @param files The files.
+ *
+ * @return true if all files were found.
+ *
+ * @throws None
+ */
+bool FtpConnection::updateFiles(sftp_session sftp, std::vector<remoteFile> &files) {
+    for (remoteFile &file : files) {
+        sftp_attributes attributes = sftp_stat(sftp, file.path.c_str());
+        if (attributes == NULL) {
+            return false;
+        }
+        file.size = attributes->size;
+        file.mtime = attributes->mtime;
+        sftp_attributes_free(attributes);
+    }
+    return true;
+}
+
+/**
+ * Reads one directory with SFTP.
+ *
+ * @param sftp The SFTP session.
+ * @param directory The directory, ending with a slash.
+ * @param isRecursive Flag indicating whether subdirectories are returned.
+ * @param files The pdf files of the directory are appended.
+ * @param subDirectories The subdirectories, ending with a slash, are appended.
+ *
+ * @return true if the directory was read.
+ *
+ * @throws None
+ */
+bool FtpConnection::readDirectory(sftp_session sftp, const std::string &directory, bool isRecursive,
+                                  std::vector<remoteFile> &files, std::vector<pendingDirectory> &subDirectories) {
+    sftp_dir dir = sftp_opendir(sftp, directory.c_str());
+    if (dir == NULL) {
+        return false;
+    }
+
+    sftp_attributes attributes;
+    while ((attributes = sftp_readdir(sftp, dir)) != NULL) {
+        const std::string fileName {attributes->name};
+        if (fileName != "." && fileName != "..") {
+            if (attributes->type == SSH_FILEXFER_TYPE_REGULAR && isPdf(fileName)) {
+                files.push_back({directory + fileName, attributes->size, static_cast<int64_t>(attributes->mtime)});
+            }
+            else if (attributes->type == SSH_FILEXFER_TYPE_DIRECTORY && isRecursive && fileName != cClaimDirectory) {
+                subDirectories.push_back({directory + fileName + "/", static_cast<int64_t>(attributes->mtime), true});
+            }
+        }
+        sftp_attributes_free(attributes);
+    }
+    sftp_closedir(dir);
+    return true;
+}
+
+/**
+ * Checks for the extension .pdf, in any case.
+ *
+ * @param fileName The file name.
+ *
+ * @return true if the file name ends with .pdf.
+ *
+ * @throws None
+ */
+bool FtpConnection::isPdf(const std::string &fileName) {
+    static constexpr std::string_view cExtension {".pdf"};
+    if (fileName.size() <= cExtension.size()) {
+        return false;
+    }
+    return std::equal(cExtension.begin(), cExtension.end(), fileName.end() - cExtension.size(), [](char a, char b) {
+        return a == std::tolower(static_cast<unsigned char>(b));
+    });
+}
+
+/**
+ * Quotes a text as a single argument for a POSIX shell.
+ *
+ * @param text The text.
+ *
+ * @return The text in single quotes, single quotes within are escaped.
+ *
+ * @throws None
+ */
+std::string FtpConnection::shellQuote(const std::string &text) {
+    std::string quoted {"'"};
+    for (const char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        }
+        else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+    return quoted;
 }
 
 /*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
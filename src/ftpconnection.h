@@ -1,18 +1,28 @@
 #ifndef FTPCONNECTION_H
 #define FTPCONNECTION_H
 
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <fcntl.h>
 #include <libssh/libssh.h>
 #include <libssh/sftp.h>
 #include "parseurl.h"
 #include "settings.h"
 #include "scan2ocr.h"
+#include "sessionpool.h"
+
+class ListingSnapshot;
+class SpoolFile;
 
 class FtpConnection {
     
 private:
+    // Borrowed from the SessionPool for the duration of one operation
+    SessionPool::Lease lease;
     ssh_session session {nullptr};
     sftp_session sftp {nullptr};
     std::string RemoteHost {""};
@@ -22,18 +32,103 @@ private:
     std::string Username {""};
     std::string FtpPassword {""};
     
-    void getConnection();
-    void disconnect();
+    // Read requests of 32 KiB are served by every server, larger ones only if the server announces them
+    static constexpr uint32_t cDefaultReadChunk = 32 * 1024;
+    static constexpr uint32_t cMaxReadChunk = 256 * 1024;
+    // Bytes requested but not yet received while downloading, covers the bandwidth delay product of slow links
+    static constexpr size_t cReadWindow = 8 * 1024 * 1024;
+    static constexpr size_t cMinReadRequests = 4;
+
+    // An interrupted download is resumed up to cMaxAttempts times, waiting twice as long before each attempt
+    static constexpr int cMaxAttempts = 6;
+    static constexpr std::chrono::seconds cRetryDelay {2};
+    static constexpr std::chrono::seconds cMaxRetryDelay {60};
+
+    enum class downloadResult { complete, interrupted, failed };
+
+    // An outstanding read request of a pipelined download
+    struct readRequest {
+        uint64_t offset {0};
+        uint32_t length {0};
+        #if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+            sftp_aio aio {nullptr};
+        #else
+            int id {0};
+        #endif
+    };
+
+    bool getConnection();
+    void disconnect(bool isBroken = false);
+
+    downloadResult download(std::unique_ptr<SpoolFile> &spool, std::string &data, bool &isResumed,
+                            const std::function<void(size_t)> &received);
+    uint32_t readChunkSize() const;
+    bool readPipelined(sftp_file remoteFile, uint64_t startOffset, uint64_t fileSize, std::string &data, bool &isEndOfFile,
+                       const std::function<void(size_t)> &received, SpoolFile *spool) const;
+    static bool beginRead(sftp_file remoteFile, readRequest &request);
+    static ssize_t waitRead(sftp_file remoteFile, readRequest &request, char *buffer);
+    static void cancelRead(readRequest &request);
+
+public:
+    // A pdf file or directory found on the server, the path includes the listed directory
+    struct remoteFile {
+        std::string path;
+        uint64_t size {0};
+        int64_t mtime {0};
+        bool isDirectory {false};
+    };
+
+private:
+    // Sessions browsing subdirectories at the same time, each with one opendir outstanding
+    static constexpr size_t cListingConnections = 4;
+    static constexpr size_t cExecReadBuffer = 64 * 1024;
+    // Files of an unchanged directory checked one by one, reading a directory takes about three round trips
+    static constexpr size_t cMaxCheckedFiles = 2;
+
+    // A directory waiting to be listed, the modification time is known if its parent was read
+    struct pendingDirectory {
+        std::string path;
+        int64_t mtime {0};
+        bool isMtimeKnown {false};
+    };
+
+    bool execCommand(const std::string &command, const std::function<void(const char *, size_t)> &output, int &exitStatus);
+    std::string remoteChecksum(const std::string &path);
+    bool listWithFind(const std::string &baseDirectory, bool isRecursive, std::vector<remoteFile> &files);
+    void listWithSftp(const pendingDirectory &baseDirectory, bool isRecursive, const ListingSnapshot *snapshot,
+                      std::vector<remoteFile> &files);
+    static void visitDirectory(sftp_session sftp, const pendingDirectory &directory, bool isRecursive, const ListingSnapshot *snapshot,
+                               std::vector<remoteFile> &files, std::vector<pendingDirectory> &subDirectories);
+    static bool updateFiles(sftp_session sftp, std::vector<remoteFile> &files);
+    static bool readDirectory(sftp_session sftp, const std::string &directory, bool isRecursive,
+                              std::vector<remoteFile> &files, std::vector<pendingDirectory> &subDirectories);
+    static bool parseFindRecord(const std::string &record, const std::string &baseDirectory, remoteFile &file);
+    size_t recoverDirectory(const std::string &claimedDirectory, const std::string &directory);
+    bool probeDirectory(const std::string &probePath, int64_t *serverTime = nullptr);
+    // Probes created in the claim directories to read and stamp the server's clock
+    static constexpr const char *cHeartbeatProbe = ".heartbeat";
+    static constexpr const char *cClockProbe = ".clock";
+    std::string basePath() const;
+    static bool isPdf(const std::string &fileName);
+    static std::string shellQuote(const std::string &text);
 
 public:
     FtpConnection(const ParseUrl &Url);
     ~FtpConnection();
 
-    bool deleteFile();
+    bool removeFiles(const std::vector<std::string> &paths, const std::string &archiveDirectory, std::vector<int> &errors);
+
+    // Directory below the listed directory where instances move the files they claimed, one subdirectory per instance
+    static constexpr const char *cClaimDirectory = ".processing";
+    bool claimFiles(const std::string &instance, std::vector<remoteFile> &files);
+    bool recoverClaims(const std::string &instance, const std::function<bool(const std::string &, int64_t)> &isOrphaned);
+    bool touchClaims(const std::string &instance);
+    static std::string unclaimedPath(const std::string &path);
     bool connected = false;
-    std::unique_ptr<std::string> getFilePtr();
+    std::unique_ptr<std::string> getFilePtr(const std::function<void(size_t)> &received = nullptr);
     
-    std::unique_ptr<std::vector<std::string>> getRemoteDir(bool isRecursive);
+    std::unique_ptr<std::vector<remoteFile>> getRemoteDir(bool isRecursive, bool isRemoteFind = false,
+                                                          const ListingSnapshot *snapshot = nullptr);
 };
 
 #endif // FTPCONNECTION_H
@@ -0,0 +1,310 @@
+#include "jbig2encoder.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Probability estimation table of ITU-T T.88 table E.1: Qe, NMPS, NLPS, SWITCH
+const std::array<Jbig2Encoder::ArithmeticEncoder::state, 47> Jbig2Encoder::ArithmeticEncoder::cStates {{
+    {0x5601, 1, 1, 1}, {0x3401, 2, 6, 0}, {0x1801, 3, 9, 0}, {0x0AC1, 4, 12, 0},
+    {0x0521, 5, 29, 0}, {0x0221, 38, 33, 0}, {0x5601, 7, 6, 1}, {0x5401, 8, 14, 0},
+    {0x4801, 9, 14, 0}, {0x3801, 10, 14, 0}, {0x3001, 11, 17, 0}, {0x2401, 12, 18, 0},
+    {0x1C01, 13, 20, 0}, {0x1601, 29, 21, 0}, {0x5601, 15, 14, 1}, {0x5401, 16, 14, 0},
+    {0x5101, 17, 15, 0}, {0x4801, 18, 16, 0}, {0x3801, 19, 17, 0}, {0x3401, 20, 18, 0},
+    {0x3001, 21, 19, 0}, {0x2801, 22, 19, 0}, {0x2401, 23, 20, 0}, {0x2201, 24, 21, 0},
+    {0x1C01, 25, 22, 0}, {0x1801, 26, 23, 0}, {0x1601, 27, 24, 0}, {0x1401, 28, 25, 0},
+    {0x1201, 29, 26, 0}, {0x1101, 30, 27, 0}, {0x0AC1, 31, 28, 0}, {0x09C1, 32, 29, 0},
+    {0x08A1, 33, 30, 0}, {0x0521, 34, 31, 0}, {0x0441, 35, 32, 0}, {0x02A1, 36, 33, 0},
+    {0x0221, 37, 34, 0}, {0x0141, 38, 35, 0}, {0x0111, 39, 36, 0}, {0x0085, 40, 37, 0},
+    {0x0049, 41, 38, 0}, {0x0025, 42, 39, 0}, {0x0015, 43, 40, 0}, {0x0009, 44, 41, 0},
+    {0x0005, 45, 42, 0}, {0x0001, 45, 43, 0}, {0x5601, 46, 46, 0}
+}};
+
+/**
+ * Encodes a binary page as JBIG2 generic region.
+ *
+ * @param pix The 1 bpp page, black pixels are 1.
+ *
+ * @return The JBIG2 stream in embedded format, empty if the page is not binary.
+ *
+ * @throws None
+ */
+std::string Jbig2Encoder::encode(Pix *pix) {
+    if (pix == nullptr || pixGetDepth(pix) != 1) {
+        return "";
+    }
+
+    const int width {pixGetWidth(pix)};
+    const int height {pixGetHeight(pix)};
+    const int wpl {pixGetWpl(pix)};
+    const l_uint32 *data {pixGetData(pix)};
+
+    // Rows above the page are white
+    const std::vector<l_uint32> whiteLine(wpl, 0);
+    auto line = [&](int y) { return (y < 0) ? whiteLine.data() : data + static_cast<size_t>(y) * wpl; };
+    auto pixel = [width](const l_uint32 *row, int x) -> int {
+        return (x < 0 || x >= width) ? 0 : (row[x >> 5] >> (31 - (x & 31))) & 1;
+    };
+
+    // Padding bits behind the last pixel of a row are not compared
+    const int fullWords {width / 32};
+    const l_uint32 lastWordMask {(width % 32 == 0) ? 0u : ~(0xFFFFFFFFu >> (width % 32))};
+    auto isSameLine = [&](const l_uint32 *a, const l_uint32 *b) {
+        for (int i = 0; i < fullWords; i++) {
+            if (a[i] != b[i]) {
+                return false;
+            }
+        }
+        return lastWordMask == 0 || ((a[fullWords] ^ b[fullWords]) & lastWordMask) == 0;
+    };
+
+    // The context tables are too large for the stack of a worker thread
+    std::unique_ptr<ArithmeticEncoder> encoder {std::make_unique<ArithmeticEncoder>()};
+    bool isTypical {false};
+
+    for (int y = 0; y < height; y++) {
+        const l_uint32 *line0 {line(y)};
+        const l_uint32 *line1 {line(y - 1)};
+        const l_uint32 *line2 {line(y - 2)};
+
+        // Typical prediction: a row equal to the row above is coded as a single bit
+        const bool isSame {isSameLine(line0, line1)};
+        encoder->encodeBit(cTypicalPredictionContext, isSame != isTypical);
+        isTypical = isSame;
+        if (isTypical) {
+            continue;
+        }
+
+        // Template 0 with the nominal adaptive pixels (3,-1), (-3,-1), (2,-2), (-2,-2):
+        // row y-2 from x-2 to x+2, row y-1 from x-3 to x+3 and row y from x-4 to x-1
+        int window2 {0}, window1 {0}, window0 {0};
+        for (int dx = -2; dx <= 2; dx++) {
+            window2 = (window2 << 1) | pixel(line2, dx);
+        }
+        for (int dx = -3; dx <= 3; dx++) {
+            window1 = (window1 << 1) | pixel(line1, dx);
+        }
+
+        for (int x = 0; x < width; x++) {
+            const int bit {pixel(line0, x)};
+            encoder->encodeBit((window2 << 11) | (window1 << 4) | window0, bit);
+
+            window0 = ((window0 << 1) | bit) & 0x0F;
+            window1 = ((window1 << 1) | pixel(line1, x + 4)) & 0x7F;
+            window2 = ((window2 << 1) | pixel(line2, x + 3)) & 0x1F;
+        }
+    }
+    const std::string codedData {encoder->finish()};
+
+    // Page information: size, resolution in pixels per meter, eventually lossless, no striping
+    std::string pageInformation;
+    const uint32_t xResolution {static_cast<uint32_t>(std::lround(pixGetXRes(pix) / 0.0254))};
+    const uint32_t yResolution {static_cast<uint32_t>(std::lround(pixGetYRes(pix) / 0.0254))};
+    appendWord(pageInformation, width);
+    appendWord(pageInformation, height);
+    appendWord(pageInformation, xResolution);
+    appendWord(pageInformation, yResolution);
+    pageInformation += '\x01';
+    pageInformation += std::string(2, '\0');
+
+    // Region information (whole page, OR operator), generic region flags (TPGDON, template 0) and adaptive pixels
+    std::string genericRegion;
+    appendWord(genericRegion, width);
+    appendWord(genericRegion, height);
+    appendWord(genericRegion, 0);
+    appendWord(genericRegion, 0);
+    genericRegion += '\0';
+    genericRegion += '\x08';
+    for (const int at : {3, -1, -3, -1, 2, -2, -2, -2}) {
+        genericRegion += static_cast<char>(static_cast<int8_t>(at));
+    }
+    genericRegion += codedData;
+
+    constexpr uint8_t cPageInformation = 48;
+    constexpr uint8_t cImmediateGenericRegion = 38;
+    return segmentHeader(0, cPageInformation, pageInformation.size()) + pageInformation
+        + segmentHeader(1, cImmediateGenericRegion, genericRegion.size()) + genericRegion;
+}
+
+/**
+ * Creates the header of a segment associated with page 1 without referred-to segments.
+ *
+ * @param number The segment number.
+ * @param type The segment type.
+ * @param dataLength The length of the segment data in bytes.
+ *
+ * @return The segment header.
+ *
+ * @throws None
+ */
+std::string Jbig2Encoder::segmentHeader(uint32_t number, uint8_t type, uint32_t dataLength) {
+    std::string header;
+    appendWord(header, number);
+    header += static_cast<char>(type);
+    header += '\0';
+    header += '\x01';
+    appendWord(header, dataLength);
+    return header;
+}
+
+/**
+ * Appends a 32 bit value in big endian byte order.
+ *
+ * @param data The data to append to.
+ * @param value The value.
+ *
+ * @throws None
+ */
+void Jbig2Encoder::appendWord(std::string &data, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+/**
+ * Initializes the coder (INITENC), all contexts start in state 0 with MPS 0.
+ *
+ * @throws None
+ */
+Jbig2Encoder::ArithmeticEncoder::ArithmeticEncoder() {
+}
+
+/**
+ * Codes one bit in the given context (ENCODE with CODEMPS / CODELPS).
+ *
+ * @param context The context index.
+ * @param bit The bit to code.
+ *
+ * @throws None
+ */
+void Jbig2Encoder::ArithmeticEncoder::encodeBit(int context, int bit) {
+    uint8_t &index = m_index[context];
+    uint8_t &mps = m_mps[context];
+    const state &current = cStates[index];
+
+    m_a -= current.qe;
+    if (bit == mps) {
+        if ((m_a & 0x8000) != 0) {
+            m_c += current.qe;
+            return;
+        }
+        if (m_a < current.qe) {
+            m_a = current.qe;
+        }
+        else {
+            m_c += current.qe;
+        }
+        index = current.nextMps;
+    }
+    else {
+        if (m_a < current.qe) {
+            m_c += current.qe;
+        }
+        else {
+            m_a = current.qe;
+        }
+        if (current.isSwitch) {
+            mps = 1 - mps;
+        }
+        index = current.nextLps;
+    }
+    renormalize();
+}
+
+/**
+ * Flushes the coder (FLUSH) and terminates the data with the 0xFF 0xAC marker.
+ *
+ * @return The arithmetically coded data.
+ *
+ * @throws None
+ */
+std::string Jbig2Encoder::ArithmeticEncoder::finish() {
+    // SETBITS
+    const uint32_t tempC {m_c + m_a};
+    m_c |= 0xFFFF;
+    if (m_c >= tempC) {
+        m_c -= 0x8000;
+    }
+
+    m_c <<= m_ct;
+    byteOut();
+    m_c <<= m_ct;
+    byteOut();
+
+    if (m_hasByte) {
+        m_data += static_cast<char>(m_b);
+    }
+    if (m_b != 0xFF) {
+        m_data += '\xFF';
+    }
+    m_data += '\xAC';
+    return std::move(m_data);
+}
+
+/**
+ * Doubles the interval until it is at least 0x8000 again (RENORME).
+ *
+ * @throws None
+ */
+void Jbig2Encoder::ArithmeticEncoder::renormalize() {
+    do {
+        m_a <<= 1;
+        m_c <<= 1;
+        m_ct--;
+        if (m_ct == 0) {
+            byteOut();
+        }
+    } while ((m_a & 0x8000) == 0);
+}
+
+/**
+ * Moves the next byte from the code register into the output (BYTEOUT).
+ * The last byte is held back, because a carry may still increase it.
+ *
+ * @throws None
+ */
+void Jbig2Encoder::ArithmeticEncoder::byteOut() {
+    bool isStuffed {m_b == 0xFF};
+    if (!isStuffed && m_c >= 0x8000000) {
+        // Carry into the held back byte
+        m_b++;
+        if (m_b == 0xFF) {
+            m_c &= 0x7FFFFFF;
+            isStuffed = true;
+        }
+    }
+
+    if (m_hasByte) {
+        m_data += static_cast<char>(m_b);
+    }
+    m_hasByte = true;
+
+    // After 0xFF only seven bits follow in the next byte
+    if (isStuffed) {
+        m_b = m_c >> 20;
+        m_c &= 0xFFFFF;
+        m_ct = 7;
+    }
+    else {
+        m_b = m_c >> 19;
+        m_c &= 0x7FFFF;
+        m_ct = 8;
+    }
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
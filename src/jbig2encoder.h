@@ -0,0 +1,78 @@
+#ifndef JBIG2ENCODER_H
+#define JBIG2ENCODER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <leptonica/allheaders.h>
+
+/*
+    Lossless JBIG2 encoder for binary pages.
+    The page is coded as one immediate lossless generic region (template 0 with
+    typical prediction) by the MQ arithmetic coder. The result is a JBIG2 stream in
+    embedded format as expected by the pdf JBIG2Decode filter: a page information
+    segment followed by the generic region segment.
+*/
+class Jbig2Encoder {
+
+public:
+    static std::string encode(Pix *pix);
+
+private:
+    // MQ arithmetic coder of ITU-T T.88 annex E
+    class ArithmeticEncoder {
+    public:
+        ArithmeticEncoder();
+        void encodeBit(int context, int bit);
+        std::string finish();
+
+    private:
+        struct state {
+            uint16_t qe;
+            uint8_t nextMps;
+            uint8_t nextLps;
+            uint8_t isSwitch;
+        };
+        static const std::array<state, 47> cStates;
+
+        // Probability state index and most probable symbol of every context
+        std::array<uint8_t, 65536> m_index {};
+        std::array<uint8_t, 65536> m_mps {};
+
+        uint32_t m_a {0x8000};
+        uint32_t m_c {0};
+        int m_ct {12};
+        int m_b {0};
+        bool m_hasByte {false};
+        std::string m_data;
+
+        void renormalize();
+        void byteOut();
+    };
+
+    // Context of the typical prediction bit for template 0
+    static constexpr int cTypicalPredictionContext = 0x9B25;
+
+    static std::string segmentHeader(uint32_t number, uint8_t type, uint32_t dataLength);
+    static void appendWord(std::string &data, uint32_t value);
+};
+
+#endif // JBIG2ENCODER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
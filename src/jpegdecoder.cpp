@@ -0,0 +1,360 @@
+#include "jpegdecoder.h"
+
+// From https://github.com/bshoshany/thread-pool:
+#include "BS_thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+namespace {
+/**
+ * Returns the thread pool shared by all decoders. Pages are already decoded on the
+ * page workers of PdfFile, a pool per decoder would start cores squared threads.
+ *
+ * @return The band decoding pool with one thread per core.
+ *
+ * @throws None
+ */
+BS::thread_pool &bandThreadPool() {
+    static BS::thread_pool threadPool;
+    return threadPool;
+}
+}
+
+/**
+ * Constructs a JpegDecoder for the given JPEG data and reads the JPEG header.
+ * The data is not copied, so it has to outlive the JpegDecoder object.
+ *
+ * @param jpegData A pointer to a string containing the complete JPEG file.
+ *
+ * @throws None
+ */
+JpegDecoder::JpegDecoder(const std::string *jpegData) : m_data(jpegData) {
+    parseHeader();
+    if (m_isValid && m_isSequential && m_restartInterval > 0) {
+        findSegments();
+    }
+}
+
+/**
+ * Decodes the JPEG data into a Pix.
+ *
+ * Large sequential JPEGs with restart markers are split into bands of complete MCU rows,
+ * which are decoded in parallel. Every other image is decoded serially by leptonica.
+ *
+ * @return A pointer to the decoded Pix, nullptr if the data could not be decoded.
+ *
+ * @throws None
+ */
+Pix *JpegDecoder::decode() {
+    const size_t pixels = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+
+    if (m_isValid && m_isSequential && hasRestartMarkers() && pixels >= cMinParallelPixels) {
+        Pix *pix = decodeParallel();
+        if (pix != nullptr) {
+            return pix;
+        }
+        #ifdef DEBUG
+            std::cout << "JpegDecoder::decode: parallel decoding failed, falling back to serial decoding" << std::endl;
+        #endif
+    }
+    return decodeSerial();
+}
+
+/**
+ * Checks whether the JPEG data can be embedded unchanged as a DCTDecode stream in a pdf file:
+ * huffman coded (baseline, extended or progressive), 8 bit and gray or RGB.
+ *
+ * @return True if the data can be passed through, false otherwise.
+ *
+ * @throws None
+ */
+bool JpegDecoder::isPdfCompatible() const {
+    const bool isHuffman = m_frameMarker >= 0xC0 && m_frameMarker <= 0xC2;
+    return m_isValid && isHuffman && m_precision == 8 && (m_components == 1 || m_components == 3);
+}
+
+/**
+ * Reads the JPEG markers up to the start of the first scan and stores the frame dimensions,
+ * the sampling factors, the restart interval and the positions needed to split the image.
+ *
+ * @throws None
+ */
+void JpegDecoder::parseHeader() {
+    const std::string &data = *m_data;
+    auto byteAt = [&data](size_t pos) { return static_cast<unsigned char>(data[pos]); };
+    auto wordAt = [&byteAt](size_t pos) { return (byteAt(pos) << 8) | byteAt(pos + 1); };
+
+    // Start of image
+    if (data.size() < 4 || byteAt(0) != 0xFF || byteAt(1) != 0xD8) {
+        return;
+    }
+
+    size_t pos {2};
+    while (pos + 4 <= data.size()) {
+        if (byteAt(pos) != 0xFF) {
+            return;
+        }
+
+        const unsigned char marker = byteAt(pos + 1);
+
+        // Fill bytes and markers without a length field
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xD9) {
+            return;
+        }
+
+        const size_t length = wordAt(pos + 2);
+        if (length < 2 || pos + 2 + length > data.size()) {
+            return;
+        }
+        const size_t content = pos + 4;
+
+        // Start of frame markers, C4 (DHT), C8 (JPG) and CC (DAC) share the range
+        const bool isFrame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+
+        if (isFrame && length >= 8) {
+            // Only baseline and extended sequential huffman coded 8 bit images can be split
+            m_isSequential = (marker == 0xC0 || marker == 0xC1) && byteAt(content) == 8;
+            m_frameMarker = marker;
+            m_precision = byteAt(content);
+            m_heightOffset = content + 1;
+            m_height = wordAt(content + 1);
+            m_width = wordAt(content + 3);
+            m_components = byteAt(content + 5);
+
+            for (int i = 0; i < m_components && 6 + 3 * static_cast<size_t>(i) + 3 <= length - 2; i++) {
+                const unsigned char sampling = byteAt(content + 6 + 3 * i + 1);
+                m_maxHorizontalSampling = std::max(m_maxHorizontalSampling, sampling >> 4);
+                m_maxVerticalSampling = std::max(m_maxVerticalSampling, sampling & 0x0F);
+            }
+        }
+        else if (marker == 0xDD && length >= 4) {
+            // Define restart interval
+            m_restartInterval = wordAt(content);
+        }
+        else if (marker == 0xDA && length >= 3) {
+            // Start of scan, the entropy coded data follows the header
+            m_scanComponents = byteAt(content);
+            m_scanStart = pos + 2 + length;
+            m_isValid = m_width > 0 && m_height > 0 && m_components > 0 && m_heightOffset > 0;
+            return;
+        }
+        pos += 2 + length;
+    }
+}
+
+/**
+ * Splits the entropy coded data of the scan at its restart markers.
+ * If the image contains more than one scan or the restart markers are out of sequence,
+ * no segments are stored and the image will be decoded serially.
+ *
+ * @throws None
+ */
+void JpegDecoder::findSegments() {
+    const std::string &data = *m_data;
+    size_t start {m_scanStart};
+    size_t pos {m_scanStart};
+    int expectedRestart {0};
+
+    while ((pos = data.find(static_cast<char>(0xFF), pos)) != std::string::npos && pos + 1 < data.size()) {
+        const unsigned char marker = static_cast<unsigned char>(data[pos + 1]);
+
+        // Stuffed zero byte or fill byte, no marker
+        if (marker == 0x00) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+
+        if (marker >= 0xD0 && marker <= 0xD7) {
+            if (marker - 0xD0 != expectedRestart) {
+                m_segments.clear();
+                return;
+            }
+            m_segments.push_back(segment{start, pos});
+            expectedRestart = (expectedRestart + 1) % 8;
+            pos += 2;
+            start = pos;
+            continue;
+        }
+
+        // Any marker other than end of image starts another scan
+        if (marker == 0xD9) {
+            m_segments.push_back(segment{start, pos});
+        }
+        else {
+            m_segments.clear();
+        }
+        return;
+    }
+
+    // Truncated data
+    m_segments.clear();
+}
+
+/**
+ * Decodes the complete JPEG data with leptonica in the calling thread.
+ *
+ * @return A pointer to the decoded Pix, nullptr on error.
+ *
+ * @throws None
+ */
+Pix *JpegDecoder::decodeSerial() {
+    const l_uint8 *l_uint8Ptr = reinterpret_cast<const l_uint8 *>(m_data->data());
+    return pixReadMem(l_uint8Ptr, m_data->size());
+}
+
+/**
+ * Decodes the JPEG data in bands of complete MCU rows. Because the DC predictors are reset
+ * at each restart marker, every band starting at a restart marker on a row boundary is a valid
+ * JPEG of its own once the header is copied and the frame height adjusted.
+ * Every band is decoded on the thread pool shared by all decoders and copied into its rows of the result.
+ *
+ * @return A pointer to the decoded Pix, nullptr if the image cannot be split or a band fails to decode.
+ *
+ * @throws None
+ */
+Pix *JpegDecoder::decodeParallel() {
+    // Size of a minimum coded unit in pixels, a non-interleaved scan consists of single blocks
+    const int mcuWidth = (m_scanComponents == 1) ? 8 : 8 * m_maxHorizontalSampling;
+    const int mcuHeight = (m_scanComponents == 1) ? 8 : 8 * m_maxVerticalSampling;
+    const size_t mcusPerRow = (m_width + mcuWidth - 1) / mcuWidth;
+    const size_t mcuRows = (m_height + mcuHeight - 1) / mcuHeight;
+    const size_t restartInterval = m_restartInterval;
+
+    // Every restart interval has to be complete except the last one
+    if (m_segments.size() != (mcusPerRow * mcuRows + restartInterval - 1) / restartInterval) {
+        return nullptr;
+    }
+
+    // A band can only start with a segment which begins at the first MCU of a row
+    std::vector<size_t> rowStarts;
+    for (size_t i = 0; i < m_segments.size(); i++) {
+        if ((i * restartInterval) % mcusPerRow == 0) {
+            rowStarts.push_back(i);
+        }
+    }
+    if (rowStarts.size() < 2) {
+        return nullptr;
+    }
+
+    BS::thread_pool &threadPool {bandThreadPool()};
+    const size_t bandCount = std::min(rowStarts.size(), static_cast<size_t>(threadPool.get_thread_count()) * cBandsPerThread);
+
+    // Distribute the possible band starts evenly, the last entry terminates the last band
+    std::vector<size_t> bandStarts;
+    for (size_t band = 0; band < bandCount; band++) {
+        bandStarts.push_back(rowStarts[band * rowStarts.size() / bandCount]);
+    }
+    bandStarts.push_back(m_segments.size());
+
+    auto bandTop = [&](size_t band) {
+        const size_t row = bandStarts[band] * restartInterval / mcusPerRow;
+        return std::min(static_cast<int>(row) * mcuHeight, m_height);
+    };
+
+    // Leptonica decodes grayscale to 8 bpp and RGB / CMYK to 32 bpp
+    Pix *pix = pixCreateNoInit(m_width, m_height, (m_components == 1) ? 8 : 32);
+    pixSetInputFormat(pix, IFF_JFIF_JPEG);
+    std::atomic<bool> failed {false};
+
+    // Only the bands of this image are waited for, the pool is shared with other pages
+    BS::multi_future<void> bands {threadPool.submit_loop<size_t>(0, bandCount, [&](const size_t band) {
+        const int top = bandTop(band);
+        const int bandHeight = ((band + 1 == bandCount) ? m_height : bandTop(band + 1)) - top;
+
+        const std::string data = bandData(bandStarts[band], bandStarts[band + 1], bandHeight);
+        Pix *pixBand = pixReadMem(reinterpret_cast<const l_uint8 *>(data.data()), data.size());
+
+        if (pixBand == nullptr || pixGetWidth(pixBand) != m_width || pixGetHeight(pixBand) != bandHeight ||
+            pixGetDepth(pixBand) != pixGetDepth(pix)) {
+            failed = true;
+        }
+        else {
+            // The bands cover disjoint rows, so they can be written concurrently
+            pixRasterop(pix, 0, top, m_width, bandHeight, PIX_SRC, pixBand, 0, 0);
+            if (band == 0) {
+                pixCopyResolution(pix, pixBand);
+                pixCopySpp(pix, pixBand);
+            }
+        }
+        pixDestroy(&pixBand);
+    }, bandCount)};
+    bands.wait();
+
+    if (failed) {
+        pixDestroy(&pix);
+        return nullptr;
+    }
+
+    #ifdef DEBUG
+        std::cout << "JpegDecoder::decodeParallel: decoded " << m_segments.size() << " restart intervals in " << bandCount << " bands" << std::endl;
+    #endif
+    return pix;
+}
+
+/**
+ * Builds a complete JPEG for the rows covered by the given segments.
+ * The header is copied with the frame height replaced by the band height,
+ * the restart markers between the segments are renumbered from RST0.
+ *
+ * @param firstSegment Index of the first segment of the band.
+ * @param lastSegment Index after the last segment of the band.
+ * @param bandHeight Height of the band in pixels.
+ *
+ * @return The JPEG data of the band.
+ *
+ * @throws None
+ */
+std::string JpegDecoder::bandData(size_t firstSegment, size_t lastSegment, int bandHeight) const {
+    const std::string &data = *m_data;
+    std::string band;
+    band.reserve(m_scanStart + m_segments[lastSegment - 1].end - m_segments[firstSegment].start + 2 * (lastSegment - firstSegment) + 2);
+
+    band.append(data, 0, m_heightOffset);
+    band.push_back(static_cast<char>((bandHeight >> 8) & 0xFF));
+    band.push_back(static_cast<char>(bandHeight & 0xFF));
+    band.append(data, m_heightOffset + 2, m_scanStart - m_heightOffset - 2);
+
+    for (size_t i = firstSegment; i < lastSegment; i++) {
+        if (i > firstSegment) {
+            band.push_back(static_cast<char>(0xFF));
+            band.push_back(static_cast<char>(0xD0 + (i - firstSegment - 1) % 8));
+        }
+        band.append(data, m_segments[i].start, m_segments[i].end - m_segments[i].start);
+    }
+
+    // End of image
+    band.push_back(static_cast<char>(0xFF));
+    band.push_back(static_cast<char>(0xD9));
+    return band;
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
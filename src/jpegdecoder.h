@@ -0,0 +1,80 @@
+#ifndef JPEGDECODER_H
+#define JPEGDECODER_H
+
+#include <string>
+#include <vector>
+
+#include <leptonica/allheaders.h>
+
+class JpegDecoder {
+
+public:
+    JpegDecoder(const std::string *jpegData);
+
+    Pix *decode();
+    bool hasRestartMarkers() const { return m_segments.size() > 1; };
+
+    int Width() const { return m_width; };
+    int Height() const { return m_height; };
+    int Components() const { return m_components; };
+    bool isValid() const { return m_isValid; };
+    bool isPdfCompatible() const;
+
+private:
+    // Minimum number of pixels of an image before it is split into bands
+    static constexpr size_t cMinParallelPixels = 4000000;
+    // Number of bands per thread to even out the load of differently filled bands
+    static constexpr int cBandsPerThread = 2;
+
+    // One entropy coded segment between two restart markers: [start, end)
+    struct segment {
+        size_t start;
+        size_t end;
+    };
+
+    const std::string *m_data;
+
+    bool m_isValid {false};
+    bool m_isSequential {false};
+    int m_width {0};
+    int m_height {0};
+    int m_components {0};
+    int m_precision {0};
+    int m_frameMarker {0};
+    int m_scanComponents {0};
+    int m_maxHorizontalSampling {1};
+    int m_maxVerticalSampling {1};
+    int m_restartInterval {0};
+
+    // Position of the height field in the SOF marker and of the first entropy coded byte
+    size_t m_heightOffset {0};
+    size_t m_scanStart {0};
+
+    std::vector<segment> m_segments;
+
+    void parseHeader();
+    void findSegments();
+
+    Pix *decodeSerial();
+    Pix *decodeParallel();
+    std::string bandData(size_t firstSegment, size_t lastSegment, int bandHeight) const;
+};
+
+#endif // JPEGDECODER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,290 @@
+#include "listingsnapshot.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+//Qt 6.x
+#include <QByteArray>
+#include <QStandardPaths>
+#include <QString>
+
+/**
+ * Constructs an empty snapshot of a network profile, call load() to read the stored one.
+ *
+ * @param profileName The name of the network profile.
+ * @param isRecursive Flag indicating whether the listing includes subdirectories.
+ *
+ * @throws None
+ */
+ListingSnapshot::ListingSnapshot(const std::string &profileName, bool isRecursive) : m_isRecursive(isRecursive) {
+    // Profile names may contain any character, they are encoded to a valid file name
+    const QString directory {QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/listings/"};
+    m_fileName = (directory + QString::fromLatin1(QByteArray::fromStdString(profileName).toPercentEncoding()) + ".snapshot").toStdString();
+}
+
+/**
+ * Reads the stored snapshot. A snapshot of a listing with different recursion is
+ * not used, it is missing the subdirectories or has too many of them.
+ *
+ * @return true if a snapshot was read.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::load() {
+    m_entries.clear();
+    m_unsettled.clear();
+    m_offered.clear();
+    std::ifstream file(m_fileName, std::ios::in | std::ios::binary);
+    std::string header;
+    if (!file || !std::getline(file, header) || header != std::string(cHeader) + (m_isRecursive ? " recursive" : " flat")) {
+        return false;
+    }
+
+    // One record per entry: type<TAB>size<TAB>mtime<TAB>path<NUL>, like the output of find.
+    // Unsettled files have the time they were first seen before the path, pending files are of type o.
+    std::string record;
+    while (std::getline(file, record, '\0')) {
+        FtpConnection::remoteFile entry;
+        const size_t sizeStart {record.find('\t')};
+        const size_t mtimeStart {(sizeStart != std::string::npos) ? record.find('\t', sizeStart + 1) : std::string::npos};
+        size_t pathStart {(mtimeStart != std::string::npos) ? record.find('\t', mtimeStart + 1) : std::string::npos};
+        const bool isUnsettled {record.compare(0, sizeStart, "u") == 0};
+        const size_t firstSeenStart {pathStart};
+        if (isUnsettled && pathStart != std::string::npos) {
+            pathStart = record.find('\t', pathStart + 1);
+        }
+        if (pathStart == std::string::npos) {
+            std::cerr << "Discarding damaged listing snapshot " << m_fileName << std::endl;
+            m_entries.clear();
+            m_unsettled.clear();
+            m_offered.clear();
+            return false;
+        }
+        if (isUnsettled) {
+            m_unsettled.emplace(record.substr(pathStart + 1), unsettledFile {
+                std::strtoull(record.c_str() + sizeStart + 1, nullptr, 10),
+                std::strtoll(record.c_str() + mtimeStart + 1, nullptr, 10),
+                std::strtoll(record.c_str() + firstSeenStart + 1, nullptr, 10)});
+            continue;
+        }
+        entry.isDirectory = (record.compare(0, sizeStart, "d") == 0);
+        entry.size = std::strtoull(record.c_str() + sizeStart + 1, nullptr, 10);
+        entry.mtime = std::strtoll(record.c_str() + mtimeStart + 1, nullptr, 10);
+        entry.path = record.substr(pathStart + 1);
+        if (record.compare(0, sizeStart, "o") == 0) {
+            m_offered.insert(entry.path);
+        }
+        m_entries.emplace(entry.path, std::move(entry));
+    }
+
+    #ifdef DEBUG
+        std::cout << "ListingSnapshot::load: " << m_entries.size() << " entries from " << m_fileName << std::endl;
+    #endif
+    return true;
+}
+
+/**
+ * Stores the snapshot. It is written to a temporary file first, so an interrupted
+ * write leaves the previous snapshot intact.
+ *
+ * @return true if the snapshot was stored.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::save() const {
+    const std::filesystem::path fileName {m_fileName};
+    // A profile may be scanned by hand while it is polled, each scan writes a temporary file of its own
+    static std::atomic<unsigned int> s_temporaryCounter {0};
+    const std::filesystem::path temporaryName {m_fileName + "." + std::to_string(getpid()) + "-"
+                                               + std::to_string(s_temporaryCounter++) + ".tmp"};
+    std::error_code error;
+    std::filesystem::create_directories(fileName.parent_path(), error);
+
+    std::ofstream file(temporaryName, std::ios::out | std::ios::binary | std::ios::trunc);
+    file << cHeader << (m_isRecursive ? " recursive" : " flat") << '\n';
+    for (const auto &[path, entry] : m_entries) {
+        const char type {entry.isDirectory ? 'd' : (m_offered.count(path) > 0 ? 'o' : 'f')};
+        file << type << '\t' << entry.size << '\t' << entry.mtime << '\t' << path << '\0';
+    }
+    for (const auto &[path, entry] : m_unsettled) {
+        file << 'u' << '\t' << entry.size << '\t' << entry.mtime << '\t' << entry.firstSeen << '\t' << path << '\0';
+    }
+    file.close();
+    if (!file) {
+        std::cerr << "Error writing listing snapshot " << temporaryName << std::endl;
+        std::filesystem::remove(temporaryName, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporaryName, fileName, error);
+    if (error) {
+        std::cerr << "Error writing listing snapshot " << fileName << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces the snapshot with a new listing. Files are no longer pending,
+ * the files offered by the scan are marked with Offered() afterwards.
+ *
+ * @param entries The files and directories listed.
+ *
+ * @throws None
+ */
+void ListingSnapshot::replace(const std::vector<FtpConnection::remoteFile> &entries) {
+    std::map<std::string, unsettledFile> unsettled;
+    m_entries.clear();
+    for (const FtpConnection::remoteFile &entry : entries) {
+        const auto it {m_unsettled.find(entry.path)};
+        if (it != m_unsettled.end()) {
+            unsettled.insert(*it);
+        }
+        else {
+            m_entries.emplace(entry.path, entry);
+        }
+    }
+    // Unsettled files that disappeared are forgotten
+    m_unsettled = std::move(unsettled);
+    m_offered.clear();
+}
+
+/**
+ * Marks files as offered but not yet processed, they stay pending until they are removed from the server.
+ *
+ * @param files The files offered by the scan.
+ *
+ * @throws None
+ */
+void ListingSnapshot::Offered(const std::vector<FtpConnection::remoteFile> &files) {
+    for (const FtpConnection::remoteFile &file : files) {
+        if (m_entries.count(file.path) > 0) {
+            m_offered.insert(file.path);
+        }
+    }
+}
+
+/**
+ * Checks whether a listed file is new or changed since the snapshot.
+ *
+ * @param file The file.
+ *
+ * @return true if the snapshot has no file with this path, size and modification time.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::isChanged(const FtpConnection::remoteFile &file) const {
+    const auto it {m_entries.find(file.path)};
+    return (it == m_entries.end() || it->second.isDirectory || it->second.size != file.size || it->second.mtime != file.mtime);
+}
+
+/**
+ * Checks whether a file was offered by a previous scan and is still on the server unchanged,
+ * it was not processed yet.
+ *
+ * @param file The file.
+ *
+ * @return true if the file is pending.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::isPending(const FtpConnection::remoteFile &file) const {
+    return (m_offered.count(file.path) > 0 && !isChanged(file));
+}
+
+/**
+ * Checks whether a new or changed file settled: it has the same size and modification
+ * time as when it was first seen at least the settle time ago. Otherwise it is kept as
+ * unsettled, with the current time if it is new or changed again.
+ *
+ * @param file The new or changed file.
+ * @param settleTime The time the file has to stay the same, 0 to take it right away.
+ *
+ * @return true if the file settled, it is no longer kept as unsettled.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::isSettled(const FtpConnection::remoteFile &file, std::chrono::seconds settleTime) {
+    const int64_t now {std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+    const auto it {m_unsettled.find(file.path)};
+    if (settleTime.count() <= 0 || (it != m_unsettled.end() && it->second.size == file.size
+                                    && it->second.mtime == file.mtime && now - it->second.firstSeen >= settleTime.count())) {
+        if (it != m_unsettled.end()) {
+            m_unsettled.erase(it);
+        }
+        return true;
+    }
+
+    if (it == m_unsettled.end() || it->second.size != file.size || it->second.mtime != file.mtime) {
+        m_unsettled[file.path] = {file.size, file.mtime, now};
+    }
+    return false;
+}
+
+/**
+ * Checks whether a directory has the same entries as in the snapshot. A directory with
+ * unsettled files is never unchanged, files growing in place do not change the directory.
+ *
+ * @param directory The directory, ending with a slash.
+ * @param mtime The current modification time of the directory.
+ *
+ * @return true if the snapshot has the directory with this modification time and no unsettled files in it.
+ *
+ * @throws None
+ */
+bool ListingSnapshot::isUnchanged(const std::string &directory, int64_t mtime) const {
+    const auto it {m_entries.find(directory)};
+    if (it == m_entries.end() || !it->second.isDirectory || it->second.mtime != mtime) {
+        return false;
+    }
+    for (auto unsettled = m_unsettled.lower_bound(directory);
+         unsettled != m_unsettled.end() && unsettled->first.compare(0, directory.size(), directory) == 0; ++unsettled) {
+        if (unsettled->first.find('/', directory.size()) == std::string::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns the entries of a directory from the snapshot.
+ *
+ * @param directory The directory, ending with a slash.
+ * @param files The pdf files of the directory are appended.
+ * @param subDirectories The subdirectories, ending with a slash, are appended.
+ *
+ * @throws None
+ */
+void ListingSnapshot::children(const std::string &directory, std::vector<FtpConnection::remoteFile> &files,
+                               std::vector<std::string> &subDirectories) const {
+    // All entries below the directory follow it in the sorted map
+    for (auto it = m_entries.upper_bound(directory); it != m_entries.end() && it->first.compare(0, directory.size(), directory) == 0; ++it) {
+        const size_t slash {it->first.find('/', directory.size())};
+        if (it->second.isDirectory && slash == it->first.size() - 1) {
+            subDirectories.push_back(it->first);
+        }
+        else if (!it->second.isDirectory && slash == std::string::npos) {
+            files.push_back(it->second);
+        }
+    }
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
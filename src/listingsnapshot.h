@@ -0,0 +1,82 @@
+#ifndef LISTINGSNAPSHOT_H
+#define LISTINGSNAPSHOT_H
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// local
+#include "ftpconnection.h"
+
+/*
+    The listing of a network profile's remote directory from the previous scan, with size
+    and modification time of every pdf file and directory. It is stored in the application
+    data directory, one file per network profile.
+    Files that are not in the snapshot or differ in size or modification time are new.
+    A directory with an unchanged modification time has the same entries as before, so
+    the entries are taken from the snapshot instead of reading the directory again.
+    Files rewritten in place do not change the directory, the lister checks them itself.
+    New files may have to settle first: they are offered once their size and modification
+    time stayed the same for the settle time, until then they are kept apart as unsettled
+    and their directories are read on every scan.
+    Offered files stay pending while they are on the server: a file that was not processed,
+    because processing failed or the program ended first, is offered again by the next scan.
+    Processed files are removed from the server and drop out of the snapshot with the listing.
+*/
+class ListingSnapshot {
+
+public:
+    ListingSnapshot(const std::string &profileName, bool isRecursive);
+
+    bool load();
+    bool save() const;
+    void replace(const std::vector<FtpConnection::remoteFile> &entries);
+
+    bool isChanged(const FtpConnection::remoteFile &file) const;
+    bool isPending(const FtpConnection::remoteFile &file) const;
+    void Offered(const std::vector<FtpConnection::remoteFile> &files);
+    bool isSettled(const FtpConnection::remoteFile &file, std::chrono::seconds settleTime);
+    bool isUnchanged(const std::string &directory, int64_t mtime) const;
+    void children(const std::string &directory, std::vector<FtpConnection::remoteFile> &files,
+                  std::vector<std::string> &subDirectories) const;
+
+private:
+    static constexpr const char *cHeader = "scan2ocr listing 1";
+
+    std::string m_fileName;
+    const bool m_isRecursive;
+    // By path, directories end with a slash and precede their entries
+    std::map<std::string, FtpConnection::remoteFile> m_entries;
+
+    // A new file waiting to settle, with the time it was first seen with this size and modification time
+    struct unsettledFile {
+        uint64_t size {0};
+        int64_t mtime {0};
+        int64_t firstSeen {0};
+    };
+    // By path, the files are not in m_entries, so they count as changed
+    std::map<std::string, unsettledFile> m_unsettled;
+    // Paths of files offered but still on the server, they are offered again by every scan
+    std::set<std::string> m_offered;
+};
+
+#endif // LISTINGSNAPSHOT_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
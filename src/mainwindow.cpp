@@ -1,7 +1,13 @@
 #include "mainwindow.h"
+#include "pixmemorypool.h"
+#include "sessionpool.h"
+#include "transfermanager.h"
+#include "downloadcache.h"
+#include "removalqueue.h"
 #include <QMetaMethod>
 #include <QStandardPaths>
 #include <QMessageBox>
+#include <QTimer>
 
 /**
  * Constructor for the MainWindow class.
@@ -29,6 +35,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 
     leDestinationDir.setCompleter(&completer);
     connectSignals();
+    startPolling();
 }
 
 /**
@@ -101,6 +108,10 @@ void MainWindow::createMenu() {
     toolBar.addAction(&openPathAction);
 
     networkProfileMenu = fileMenu->addMenu(tr("Remote &profiles"));
+    scanAllAction.setStatusTip(tr("Scan the directories of all remote profiles at the same time."));
+    scanAllAction.setIcon(QIcon(":/images/network.png"));
+    QObject::connect(&scanAllAction, &QAction::triggered, this, &MainWindow::scanAllProfiles);
+    fileMenu->addAction(&scanAllAction);
     fileMenu->addSeparator();
 
    // Get all network profile entries and create a menu entry for each of them
@@ -221,6 +232,10 @@ void MainWindow::createNetworkMenuEntry(Settings::networkProfile *netProfile) {
         tbDefaultNetworkEntry.setText(netProfile->name.c_str());
         tbDefaultNetworkEntry.setProperty("Url", QVariant::fromValue(netProfile->url));
         tbDefaultNetworkEntry.setProperty("IsRecursive", QVariant::fromValue(netProfile->isRecursive));
+        tbDefaultNetworkEntry.setProperty("IsRemoteFind", QVariant::fromValue(netProfile->isRemoteFind));
+        tbDefaultNetworkEntry.setProperty("IsIncremental", QVariant::fromValue(netProfile->isIncremental));
+        tbDefaultNetworkEntry.setProperty("IsClaiming", QVariant::fromValue(netProfile->isClaiming));
+        tbDefaultNetworkEntry.setProperty("ProfileName", QVariant::fromValue(QString::fromStdString(netProfile->name)));
         tbDefaultNetworkEntry.setProperty("DocumentProfileIndex", QVariant::fromValue(netProfile->documentProfileIndex));
         toolBar.insertWidget(&renameAction, &tbDefaultNetworkEntry);
         tbDefaultNetworkEntry.setToolTip(tr("Scan a directory on a remote server for pdf files."));
@@ -245,6 +260,10 @@ void MainWindow::createNetworkMenuEntry(Settings::networkProfile *netProfile) {
     networkProfileAction->setIcon(QIcon(":/images/network.png"));
     networkProfileAction->setProperty("Url", QVariant::fromValue(netProfile->url));
     networkProfileAction->setProperty("IsRecursive", QVariant::fromValue(netProfile->isRecursive));
+    networkProfileAction->setProperty("IsRemoteFind", QVariant::fromValue(netProfile->isRemoteFind));
+    networkProfileAction->setProperty("IsIncremental", QVariant::fromValue(netProfile->isIncremental));
+    networkProfileAction->setProperty("IsClaiming", QVariant::fromValue(netProfile->isClaiming));
+    networkProfileAction->setProperty("ProfileName", QVariant::fromValue(QString::fromStdString(netProfile->name)));
     networkProfileAction->setProperty("DocumentProfileIndex", QVariant::fromValue(netProfile->documentProfileIndex));
     networkProfileMenu->addAction(networkProfileAction);
     QObject::connect(networkProfileAction, &QAction::triggered, this, &MainWindow::openNetwork);
@@ -304,6 +323,12 @@ void MainWindow::settingsMenu() {
    SettingsUI settingsDialog;
    settingsDialog.showDialog();
    settings.readValues();
+   PixMemoryPool::instance().MemoryLimit(static_cast<size_t>(settings.PixPoolLimit()) * 1024 * 1024);
+   SessionPool::instance().Limits(settings.ConnectionsPerHost(), settings.ConnectionIdleTimeout());
+   TransferManager::instance().Limits(settings.ConcurrentTransfers(), settings.ConnectionsPerHost(),
+                                      settings.BandwidthLimit(), settings.HostBandwidthLimit());
+   DownloadCache::instance().Limit(static_cast<uint64_t>(settings.DownloadCacheLimit()) * 1024 * 1024);
+   RemovalQueue::instance().ArchiveDirectory(settings.RemoteArchiveDir().toStdString());
 
     //Update (clear) networkMenu and toolBar
     if (tbDefaultNetworkEntry.parent() != nullptr) {
@@ -336,6 +361,7 @@ void MainWindow::settingsMenu() {
 
     // Set the default document directory
     leDestinationDir.setText(settings.DestinationDir());
+    startPolling();
 }
 
 /**
@@ -449,6 +475,7 @@ void MainWindow::openPath(){
 
 /**
  * Opens a network directory and initializes the corresponding Directory object.
+ * A profile listing only new or changed files is scanned in the background like a poll.
  *
  * @return void
  *
@@ -458,14 +485,29 @@ void MainWindow::openNetwork() {
     QObject *senderObject = QObject::sender();
 
     bool isRecursive {senderObject->property("IsRecursive").toBool()};
+    bool isRemoteFind {senderObject->property("IsRemoteFind").toBool()};
     ParseUrl url{senderObject->property("Url").value<ParseUrl>()};
     int documentProfileIndex {senderObject->property("DocumentProfileIndex").toInt()};
 
+    // Incremental scans share the snapshot with the poller, they run like a poll, one at a time per profile
+    if (senderObject->property("IsIncremental").toBool()) {
+        const std::string profileName {senderObject->property("ProfileName").toString().toStdString()};
+        for (int i = 0; i < settings.networkProfileCount(); i++) {
+            if (settings.NetworkProfile(i)->name == profileName) {
+                if (!scanProfile(*settings.NetworkProfile(i))) {
+                    QMessageBox::information(this, tr("Scan in progress"), tr("This profile is still being scanned."));
+                }
+                return;
+            }
+        }
+    }
+
     #ifdef DEBUG
         std::cout << "MainWindow::openNetwork() creating new instance of Directory " << url.Url() << " with parent_ptr to " << this << std::endl;
     #endif
 
-    p_Directory = std::make_shared<Directory> (url, this, isRecursive, documentProfileIndex);
+    p_Directory = std::make_shared<Directory> (url, this, isRecursive, documentProfileIndex, isRemoteFind);
+    p_Directory->Claiming(senderObject->property("IsClaiming").toBool());
 
     #ifdef DEBUG
         std::cout << "MainWindow::openNetwork() connecting foundNewFile at " << p_Directory.get() << " to newFileFound at" << this << std::endl;
@@ -477,6 +519,7 @@ void MainWindow::openNetwork() {
 
 /**
  * Adds a new PDF file to the list of PDF files in the MainWindow.
+ * A file still in the list or waiting for its removal from the server is skipped.
  *
  * @param ptr_Url a shared pointer to a ParseUrl object representing the URL of the PDF file
  * @param documentProfileIndex the index of the document profile to use for the new PDF file
@@ -488,12 +531,17 @@ void MainWindow::newFileFound(std::shared_ptr<ParseUrl>ptr_Url, int documentProf
         std::cout << "MainWindow::newFileFound() on: " << ptr_Url->Url() << std::endl;
     #endif
     
+    const std::string url {ptr_Url->Url()};
+    if (foundUrls.count(url) > 0 || RemovalQueue::instance().isQueued(url)) {
+        return;
+    }
+    foundUrls.insert(url);
     vec_pdfFiles.emplace_back(std::make_shared<PdfFile> (*(ptr_Url), this, documentProfileIndex));
 }
 
 /**
- * Processes the list of PDF files by initializing each file, adding its name to a list widget,
- * and setting the current row if needed.
+ * Starts processing the new PDF files in the background, adds their names to the list widget
+ * and sets the current row if needed. The source file name is shown until the file is processed.
  *
  * @param None
  *
@@ -502,14 +550,157 @@ void MainWindow::newFileFound(std::shared_ptr<ParseUrl>ptr_Url, int documentProf
  * @throws None
  */
 void MainWindow::processFiles() {
-    for (auto &pdfFile : vec_pdfFiles) {
-        pdfFile->initialize();
-        lsFiles.addItem(QString::fromStdString(pdfFile->FileName()));
+    prefetcher.Limits(settings.ConcurrentTransfers(), static_cast<size_t>(settings.PrefetchLimit()) * 1024 * 1024);
+
+    // Files are processed one after the other in the background, their pages are shown as they are written
+    for (size_t i = startedFiles; i < vec_pdfFiles.size(); i++) {
+        std::shared_ptr<PdfFile> pdfFile {vec_pdfFiles.at(i)};
+        lsFiles.addItem(QString::fromStdString(pdfFile->SourceFileName()));
 
         if(lsFiles.currentRow() == -1) {
             lsFiles.setCurrentRow(0);
         }
+        fileScheduler.add(pdfFile);
     }
+    startedFiles = vec_pdfFiles.size();
+    scheduleFiles();
+}
+
+/**
+ * Hands the next files of the FileScheduler to the background processing. Files are
+ * scheduled one more than are downloaded ahead, every processed file schedules the next.
+ *
+ * @throws None
+ */
+void MainWindow::scheduleFiles() {
+    while (std::shared_ptr<PdfFile> pdfFile {fileScheduler.schedule(prefetcher.Depth() + 1)}) {
+        prefetcher.add(pdfFile);
+        fileProcessor.detach_task([this] {
+            std::shared_ptr<PdfFile> pdfFile {fileScheduler.next()};
+            prefetcher.begin(pdfFile);
+            pdfFile->initialize();
+            prefetcher.end(pdfFile);
+            QMetaObject::invokeMethod(this, [this] { scheduleFiles(); }, Qt::QueuedConnection);
+        });
+    }
+}
+
+/**
+ * Scans the directories of all network profiles at the same time.
+ *
+ * @throws None
+ */
+void MainWindow::scanAllProfiles() {
+    for (int i = 0; i < settings.networkProfileCount(); i++) {
+        scanProfile(*settings.NetworkProfile(i));
+    }
+}
+
+/**
+ * Lists the directory of a network profile in the background with the options of the
+ * profile. The files found are added on the GUI thread when the listing is complete.
+ * A polled profile always uses the incremental listing and new files have to settle.
+ *
+ * @param profile The network profile.
+ * @param isPolled true if the scan was started by the poller, it schedules the next poll when done.
+ *
+ * @return false if the profile is still being scanned.
+ *
+ * @throws None
+ */
+bool MainWindow::scanProfile(const Settings::networkProfile &profile, bool isPolled) {
+    if (!scanningProfiles.insert(profile.name).second) {
+        return false;
+    }
+
+    profileScanner.detach_task([this, profile, isPolled] {
+        std::vector<std::pair<std::shared_ptr<ParseUrl>, int>> foundFiles;
+        Directory directory(profile.url, nullptr, profile.isRecursive, profile.documentProfileIndex, profile.isRemoteFind);
+        if (profile.isIncremental || isPolled) {
+            directory.Snapshot(profile.name, isPolled ? cSettleTime : std::chrono::seconds(0));
+        }
+        directory.Claiming(profile.isClaiming);
+        QObject::connect(&directory, &Directory::foundNewFile, [&foundFiles](std::shared_ptr<ParseUrl> ptr_Url, int documentProfileIndex) {
+            foundFiles.emplace_back(ptr_Url, documentProfileIndex);
+        });
+        directory.initialize();
+
+        #ifdef DEBUG
+            std::cout << "MainWindow::scanProfile: " << foundFiles.size() << " files in " << profile.name << std::endl;
+        #endif
+
+        const bool isActive {directory.ChangedFiles() > 0};
+        QMetaObject::invokeMethod(this, [this, name = profile.name, foundFiles = std::move(foundFiles), isPolled, isActive] {
+            for (const auto &[ptr_Url, documentProfileIndex] : foundFiles) {
+                newFileFound(ptr_Url, documentProfileIndex);
+            }
+            scanningProfiles.erase(name);
+            processFiles();
+
+            const auto interval {pollIntervals.find(name)};
+            if (isPolled && interval != pollIntervals.end()) {
+                // Polled quickly while files arrive or settle, less often the longer the directory stays idle
+                interval->second = isActive ? cMinPollInterval : std::min(interval->second * 2, cMaxPollInterval);
+                schedulePoll(name);
+            }
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+/**
+ * Starts polling the network profiles set to be checked automatically, which are not
+ * polled yet. Profiles no longer set stop at their next poll.
+ *
+ * @throws None
+ */
+void MainWindow::startPolling() {
+    for (int i = 0; i < settings.networkProfileCount(); i++) {
+        const Settings::networkProfile *profile {settings.NetworkProfile(i)};
+        if (profile->isPolling && pollIntervals.emplace(profile->name, cMinPollInterval).second) {
+            pollProfile(profile->name);
+        }
+    }
+}
+
+/**
+ * Scans a polled network profile, unless it was removed or is no longer polled.
+ *
+ * @param profileName The name of the network profile.
+ *
+ * @throws None
+ */
+void MainWindow::pollProfile(const std::string &profileName) {
+    const Settings::networkProfile *profile {nullptr};
+    for (int i = 0; i < settings.networkProfileCount(); i++) {
+        if (settings.NetworkProfile(i)->name == profileName) {
+            profile = settings.NetworkProfile(i);
+        }
+    }
+    if (profile == nullptr || !profile->isPolling) {
+        pollIntervals.erase(profileName);
+        return;
+    }
+
+    #ifdef DEBUG
+        std::cout << "MainWindow::pollProfile: " << profileName << ", interval " << pollIntervals.at(profileName).count() << " s" << std::endl;
+    #endif
+
+    // A scan started by hand is still running, the poll waits for the next turn
+    if (!scanProfile(*profile, true)) {
+        schedulePoll(profileName);
+    }
+}
+
+/**
+ * Schedules the next poll of a network profile after its current interval.
+ *
+ * @param profileName The name of the network profile.
+ *
+ * @throws None
+ */
+void MainWindow::schedulePoll(const std::string &profileName) {
+    QTimer::singleShot(pollIntervals.at(profileName), this, [this, profileName] { pollProfile(profileName); });
 }
 
 /**
@@ -555,11 +746,7 @@ void MainWindow::fileSelected(){
     #endif
 
     leFileName.setText(QString::fromStdString(vec_pdfFiles.at(Index)->FileName()));
-    QString pdfFile = QString::fromStdString(vec_pdfFiles.at(Index)->pdfFileName());
-    pdfDocument.load(pdfFile);
-    
-    pdfView.setDocument(&pdfDocument);
-    vec_pdfFiles.at(Index)->returnFileContent()->close();
+    showPreview(Index);
 
     leFileName.setFocus();
 
@@ -570,6 +757,57 @@ void MainWindow::fileSelected(){
     }
 }
 
+/**
+ * Shows the processed pdf of a file. While the file is still processed,
+ * the pages written so far are shown.
+ *
+ * @param index The index of the file in vec_pdfFiles.
+ *
+ * @throws None
+ */
+void MainWindow::showPreview(int index) {
+    // The viewer reads the mapped file on demand, the previous mapping is released after loading
+    std::shared_ptr<QIODevice> pdfContent {vec_pdfFiles.at(index)->returnFileContent()};
+    if (pdfContent->isOpen()) {
+        pdfDocument.load(pdfContent.get());
+    }
+    else if (vec_pdfFiles.at(index)->isFinished()) {
+        pdfDocument.load(QString::fromStdString(vec_pdfFiles.at(index)->pdfFileName()));
+    }
+    else {
+        pdfDocument.close();
+    }
+    previewContent = std::move(pdfContent);
+
+    pdfView.setDocument(&pdfDocument);
+}
+
+/**
+ * Shows newly written pages of the selected file while it is processed.
+ * The reviewer stays at the position in the document.
+ *
+ * @param pageCount The number of pages written so far.
+ *
+ * @throws None
+ */
+void MainWindow::previewUpdate([[maybe_unused]] int pageCount) {
+    const int index {lsFiles.currentRow()};
+    if (index < 0 || index >= static_cast<int>(vec_pdfFiles.size()) || vec_pdfFiles.at(index).get() != sender()) {
+        return;
+    }
+    if (vec_pdfFiles.at(index)->isFinished()) {
+        return;
+    }
+
+    #ifdef DEBUG
+        std::cout << "MainWindow::previewUpdate(), Index:" << index << " pages:" << pageCount << std::endl;
+    #endif
+
+    const int scrollPosition {pdfView.verticalScrollBar()->value()};
+    showPreview(index);
+    pdfView.verticalScrollBar()->setValue(scrollPosition);
+}
+
 /**
  * Updates the statusbar of the MainWindow.
  *
@@ -636,9 +874,15 @@ void MainWindow::cancel(){
  * @throws None
  */
 void MainWindow::deleteFile (const int element) {
+    if (vec_pdfFiles.at(element) && !vec_pdfFiles.at(element)->isFinished()) {
+        QMessageBox::information(this, tr("File in progress"), tr("The file is still being processed."));
+        return;
+    }
     if (vec_pdfFiles.at(element)) {
-        // Remove scanned File
-        vec_pdfFiles.at(element)->removeFile();
+        // Remove scanned File, a new file of the same name is listed again
+        if (vec_pdfFiles.at(element)->removeFile()) {
+            foundUrls.erase(vec_pdfFiles.at(element)->SourceUrl());
+        }
         
         // Remove the currently selected item from lsFiles
         lsFiles.takeItem(element);
@@ -680,12 +924,24 @@ void MainWindow::renameToFinalName() {
     }
 
     const int element {lsFiles.currentRow()};
-    
+    if (!vec_pdfFiles.at(element)->isFinished()) {
+        QMessageBox::information(this, tr("File in progress"), tr("The file is still being processed."));
+        return;
+    }
+
     bool retVal = vec_pdfFiles.at(element)->renameToFileName(destinationDir + leFileName.text().toStdString());
     if (retVal) {
-        vec_pdfFiles.at(element)->removeFile();
+        if (vec_pdfFiles.at(element)->removeFile()) {
+            foundUrls.erase(vec_pdfFiles.at(element)->SourceUrl());
+        }
         lsFiles.takeItem(element);
-        (element > 0) ? lsFiles.setCurrentRow(element-1) : pdfDocument.close();
+        if (element > 0) {
+            lsFiles.setCurrentRow(element-1);
+        }
+        else {
+            pdfDocument.close();
+            previewContent.reset();
+        }
     }
     else {
         QMessageBox::critical(this, tr("Error while renaming file"), tr("Error while renaming file"));
@@ -744,6 +1000,24 @@ void MainWindow::filesProcessed() {
     #ifdef DEBUG
         std::cout << "MainWindow::filesProcessed() from " << this << std::endl;
     #endif
+
+    // The proposed file name is known now, the selected file is shown completely
+    for (int i = 0; i < static_cast<int>(vec_pdfFiles.size()) && i < lsFiles.count(); i++) {
+        if (vec_pdfFiles.at(i).get() == sender()) {
+            lsFiles.item(i)->setText(QString::fromStdString(vec_pdfFiles.at(i)->FileName()));
+            if (i == lsFiles.currentRow()) {
+                const int scrollPosition {pdfView.verticalScrollBar()->value()};
+                fileSelected();
+                pdfView.verticalScrollBar()->setValue(scrollPosition);
+            }
+        }
+    }
+
+    for (const auto &pdfFile : vec_pdfFiles) {
+        if (!pdfFile->isFinished()) {
+            return;
+        }
+    }
     pbProgress.hide();
 }
 
@@ -1,9 +1,18 @@
 #pragma once
 
 #include "pdffile.h"
+#include "prefetcher.h"
+#include "filescheduler.h"
 #include "parseurl.h"
 #include "settings.h"
 
+// From https://github.com/bshoshany/thread-pool:
+#include "BS_thread_pool.hpp"
+
+#include <chrono>
+#include <map>
+#include <set>
+
 #include <QObject>
 #include <QFileDialog>
 #include <QtCore/QVariant>
@@ -58,6 +67,7 @@ public slots:
     void newFileFound(std::shared_ptr<ParseUrl>ptr_Url, int documentProfileIndex);
     void statusUpdate();
     void filesProcessed();
+    void previewUpdate(int pageCount);
     void setMaxProgress();
     void renameToFinalName();
     void getDestinationDir();
@@ -69,6 +79,7 @@ private slots:
     void openFile();
     void openPath();
     void openNetwork();
+    void scanAllProfiles();
     void settingsMenu();
     void cancel();
     void about();
@@ -84,6 +95,12 @@ private:
     void setText();
     void connectSignals();
     void processFiles();
+    void scheduleFiles();
+    bool scanProfile(const Settings::networkProfile &profile, bool isPolled = false);
+    void startPolling();
+    void pollProfile(const std::string &profileName);
+    void schedulePoll(const std::string &profileName);
+    void showPreview(int index);
     void deleteFile (const int element);
     
     QWidget centralWidget {this};
@@ -102,6 +119,7 @@ private:
     QMenu *networkProfileMenu {nullptr};
     QAction openFileAction {tr("&Open File..."), this};
     QAction openPathAction {tr("Open &Directory..."), this};
+    QAction scanAllAction {tr("Scan &All Profiles"), this};
     QAction addProfileAction {tr("Add &Profile..."), this};
     QAction deleteProfileAction {tr("Delete &Profile..."), this};
     QAction defaultProfileAction {tr("Default &Profile..."), this};
@@ -116,8 +134,30 @@ private:
     QComboBox cbDocumentProfiles {nullptr};
 
     std::vector <std::shared_ptr<PdfFile>> vec_pdfFiles;    
+    // Urls of the files listed and not removed yet, scans offer files again until they are removed from the server
+    std::set<std::string> foundUrls;
     std::shared_ptr<Directory> p_Directory;                 
-
+    // Files before this index in vec_pdfFiles are processed or in progress
+    size_t startedFiles {0};
+    // Downloads the next remote files while a file is processed
+    Prefetcher prefetcher;
+    // Orders the files of all sources for processing
+    FileScheduler fileScheduler;
+    // Processes one file after the other, destroyed first to wait for the running file
+    BS::thread_pool fileProcessor {1};
+    // Lists the directories of network profiles in the background, each profile once at a time
+    static constexpr int cProfileScanners = 8;
+    std::set<std::string> scanningProfiles;
+    BS::thread_pool profileScanner {cProfileScanners};
+    // Polled network profiles by name with the time until their next scan
+    static constexpr std::chrono::seconds cMinPollInterval {10};
+    static constexpr std::chrono::seconds cMaxPollInterval {300};
+    // A new file is taken once its size and modification time stayed the same this long
+    static constexpr std::chrono::seconds cSettleTime {30};
+    std::map<std::string, std::chrono::seconds> pollIntervals;
+
+    // Declared before the document, which reads from it until it is destroyed
+    std::shared_ptr<QIODevice> previewContent;
     QPdfDocument pdfDocument;
     QCompleter completer;
 
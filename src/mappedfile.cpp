@@ -0,0 +1,82 @@
+#include "mappedfile.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * Maps the file and opens the device read-only on the mapping.
+ *
+ * @param fileName The file to map.
+ * @param length The number of bytes of the file to use, -1 for the whole file.
+ * @param tail Data following the used part of the file.
+ *
+ * @throws None
+ */
+MappedFile::MappedFile(const QString &fileName, qint64 length, const std::string &tail) : m_file(fileName), m_tail(tail) {
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const qint64 fileSize {m_file.size()};
+    m_length = (length < 0) ? fileSize : length;
+    if (m_length > 0 && m_length <= fileSize) {
+        m_data = m_file.map(0, m_length);
+    }
+    if (m_data == nullptr) {
+        m_file.close();
+        m_length = 0;
+        return;
+    }
+    open(QIODevice::ReadOnly);
+}
+
+MappedFile::~MappedFile() {
+    close();
+    if (m_data != nullptr) {
+        m_file.unmap(m_data);
+    }
+}
+
+/**
+ * Copies data from the current position, first from the mapping, then from the tail.
+ *
+ * @param data The buffer to fill.
+ * @param maxSize The size of the buffer.
+ *
+ * @return The number of bytes copied, 0 at the end of the data.
+ *
+ * @throws None
+ */
+qint64 MappedFile::readData(char *data, qint64 maxSize) {
+    qint64 position {pos()};
+    qint64 copied {0};
+    if (position < m_length) {
+        const qint64 count {std::min(maxSize, m_length - position)};
+        std::memcpy(data, m_data + position, count);
+        copied += count;
+        position += count;
+    }
+    const qint64 tailPosition {position - m_length};
+    if (copied < maxSize && tailPosition < static_cast<qint64>(m_tail.size())) {
+        const qint64 count {std::min(maxSize - copied, static_cast<qint64>(m_tail.size()) - tailPosition)};
+        std::memcpy(data + copied, m_tail.data() + tailPosition, count);
+        copied += count;
+    }
+    return copied;
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
@@ -0,0 +1,56 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+
+/*
+    Read-only device on a memory mapped file.
+    The data is read from the page cache on access, opening the device does not read
+    or copy the file. A file still being written can be read up to a given length,
+    followed by data held in memory (e.g. the end of a preliminary pdf document).
+    The device is not open if the file could not be mapped.
+*/
+class MappedFile : public QIODevice {
+
+public:
+    explicit MappedFile(const QString &fileName, qint64 length = -1, const std::string &tail = std::string());
+    ~MappedFile() override;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isSequential() const override { return false; };
+    qint64 size() const override { return m_length + static_cast<qint64>(m_tail.size()); };
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *, qint64) override { return -1; };
+
+private:
+    QFile m_file;
+    uchar *m_data {nullptr};
+    qint64 m_length {0};
+    const std::string m_tail;
+};
+
+#endif // MAPPEDFILE_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,234 @@
+#include "mrcencoder.h"
+
+#include <cmath>
+
+/**
+ * Constructs the encoder for a page.
+ *
+ * @param pix The decoded colour or gray page, the encoder keeps its own reference.
+ * @param resolution The resolution of the page in ppi.
+ * @param useJbig2 Encodes the text mask as JBIG2 instead of G4.
+ *
+ * @throws None
+ */
+MrcEncoder::MrcEncoder(Pix *pix, int resolution, bool useJbig2) : m_pix(pixClone(pix)), m_resolution(resolution), m_useJbig2(useJbig2) {
+}
+
+MrcEncoder::~MrcEncoder() {
+    pixDestroy(&m_pix);
+}
+
+/**
+ * Splits the page into its layers and encodes them.
+ *
+ * @return The images of the page in drawing order: background, text mask and foreground
+ *  drawn through the mask. Only the background if the page has no text,
+ *  an empty vector if the page could not be encoded.
+ *
+ * @throws None
+ */
+std::vector<PdfWriter::image> MrcEncoder::encode() {
+    std::vector<PdfWriter::image> images;
+    if (m_pix == nullptr || m_resolution <= 0) {
+        return images;
+    }
+
+    Pix *pixColor {(pixGetDepth(m_pix) == 32) ? pixClone(m_pix) : pixConvertTo32(m_pix)};
+    Pix *pixGray {(pixColor != nullptr) ? pixConvertRGBToGray(pixColor, 0.0f, 0.0f, 0.0f) : nullptr};
+    Pix *mask {(pixGray != nullptr) ? textMask(pixGray) : nullptr};
+    pixDestroy(&pixGray);
+    if (mask == nullptr) {
+        pixDestroy(&pixColor);
+        return images;
+    }
+
+    l_int32 textPixels {0};
+    pixCountPixels(mask, &textPixels, nullptr);
+
+    // The encoder already runs concurrently to the ocr of its page and to the other pages,
+    // so the layers are encoded one after the other instead of on a pool of their own
+    images.push_back(background(pixCopy(nullptr, pixColor), pixCopy(nullptr, mask)));
+    if (textPixels > 0) {
+        images.push_back(textLayer(pixCopy(nullptr, mask)));
+        images.back().isMask = true;
+        images.push_back(foreground(pixCopy(nullptr, pixColor), pixCopy(nullptr, mask)));
+        images.back().mask = 1;
+    }
+    pixDestroy(&mask);
+    pixDestroy(&pixColor);
+
+    for (const PdfWriter::image &image : images) {
+        if (image.data.empty()) {
+            images.clear();
+            break;
+        }
+    }
+    return images;
+}
+
+/**
+ * Binarises the page and removes photos (halftone regions) from the result,
+ * which leaves text and line art in the mask.
+ *
+ * @param pixGray The 8 bpp page.
+ *
+ * @return The 1 bpp text mask, nullptr on failure.
+ *
+ * @throws None
+ */
+Pix *MrcEncoder::textMask(Pix *pixGray) const {
+    Pix *mask {pixOtsuThreshOnBackgroundNorm(pixGray, nullptr, 10, 15, 100, 50, 255, 2, 2, 0.1f, nullptr)};
+    if (mask == nullptr) {
+        return nullptr;
+    }
+
+    // Reduce the mask by powers of two to the resolution of the halftone detection
+    int reduction {1};
+    Pix *pixReduced {pixClone(mask)};
+    while (m_resolution / (2 * reduction) >= cHalftoneResolution) {
+        Pix *pixNext {pixReduceRankBinaryCascade(pixReduced, 1, 0, 0, 0)};
+        pixDestroy(&pixReduced);
+        pixReduced = pixNext;
+        reduction *= 2;
+        if (pixReduced == nullptr) {
+            return mask;
+        }
+    }
+
+    l_int32 hasHalftone {0};
+    Pix *halftone {pixGenerateHalftoneMask(pixReduced, nullptr, &hasHalftone, nullptr)};
+    pixDestroy(&pixReduced);
+
+    if (halftone != nullptr && hasHalftone) {
+        Pix *halftoneMask {(reduction > 1) ? pixExpandReplicate(halftone, reduction) : pixClone(halftone)};
+        if (halftoneMask != nullptr) {
+            pixSubtract(mask, mask, halftoneMask);
+            pixDestroy(&halftoneMask);
+        }
+    }
+    pixDestroy(&halftone);
+
+    return mask;
+}
+
+/**
+ * Creates the background layer: the text is painted over with the paper colour
+ * and the page is reduced to the background resolution.
+ *
+ * @param pixBackground A 32 bpp copy of the page, destroyed by this function.
+ * @param mask A copy of the text mask, destroyed by this function.
+ *
+ * @return The jpeg encoded background, empty on failure.
+ *
+ * @throws None
+ */
+PdfWriter::image MrcEncoder::background(Pix *pixBackground, Pix *mask) const {
+    // Antialiased edges of the characters belong to the text as well
+    Pix *textArea {pixDilateBrick(nullptr, mask, 3, 3)};
+    pixDestroy(&mask);
+    Pix *paperArea {(textArea != nullptr) ? pixInvert(nullptr, textArea) : nullptr};
+
+    l_float32 red {255.0f}, green {255.0f}, blue {255.0f};
+    if (paperArea != nullptr) {
+        pixGetAverageMaskedRGB(pixBackground, paperArea, 0, 0, 4, L_MEAN_ABSVAL, &red, &green, &blue);
+    }
+    l_uint32 paperColor {0};
+    composeRGBPixel(std::lround(red), std::lround(green), std::lround(blue), &paperColor);
+    if (pixBackground != nullptr && textArea != nullptr) {
+        pixPaintThroughMask(pixBackground, textArea, 0, 0, paperColor);
+    }
+    pixDestroy(&paperArea);
+    pixDestroy(&textArea);
+
+    Pix *pixScaled {scaleTo(pixBackground, cBackgroundResolution)};
+    pixDestroy(&pixBackground);
+
+    PdfWriter::image image {PdfWriter::encodeImage(pixScaled, L_JPEG_ENCODE, cBackgroundQuality)};
+    pixDestroy(&pixScaled);
+    return image;
+}
+
+/**
+ * Encodes the text mask losslessly as JBIG2 or G4.
+ *
+ * @param mask A copy of the text mask, destroyed by this function.
+ *
+ * @return The encoded mask, empty on failure.
+ *
+ * @throws None
+ */
+PdfWriter::image MrcEncoder::textLayer(Pix *mask) const {
+    PdfWriter::image image {m_useJbig2 ? PdfWriter::jbig2Image(mask) : PdfWriter::encodeImage(mask, L_G4_ENCODE)};
+    pixDestroy(&mask);
+    return image;
+}
+
+/**
+ * Creates the foreground layer: everything except the text is painted with the
+ * average text colour, so the reduction keeps the colour of the characters.
+ *
+ * @param pixForeground A 32 bpp copy of the page, destroyed by this function.
+ * @param mask A copy of the text mask, destroyed by this function.
+ *
+ * @return The jpeg encoded foreground, empty on failure.
+ *
+ * @throws None
+ */
+PdfWriter::image MrcEncoder::foreground(Pix *pixForeground, Pix *mask) const {
+    Pix *paperArea {pixInvert(nullptr, mask)};
+
+    l_float32 red {0.0f}, green {0.0f}, blue {0.0f};
+    pixGetAverageMaskedRGB(pixForeground, mask, 0, 0, 1, L_MEAN_ABSVAL, &red, &green, &blue);
+    l_uint32 textColor {0};
+    composeRGBPixel(std::lround(red), std::lround(green), std::lround(blue), &textColor);
+    if (pixForeground != nullptr && paperArea != nullptr) {
+        pixPaintThroughMask(pixForeground, paperArea, 0, 0, textColor);
+    }
+    pixDestroy(&paperArea);
+    pixDestroy(&mask);
+
+    Pix *pixScaled {scaleTo(pixForeground, cForegroundResolution)};
+    pixDestroy(&pixForeground);
+
+    PdfWriter::image image {PdfWriter::encodeImage(pixScaled, L_JPEG_ENCODE, cForegroundQuality)};
+    pixDestroy(&pixScaled);
+    return image;
+}
+
+/**
+ * Reduces a page to the given resolution by area mapping, pages at or below it are kept.
+ *
+ * @param pix The 32 bpp page.
+ * @param resolution The target resolution in ppi.
+ *
+ * @return The reduced page, nullptr on failure.
+ *
+ * @throws None
+ */
+Pix *MrcEncoder::scaleTo(Pix *pix, int resolution) const {
+    if (pix == nullptr) {
+        return nullptr;
+    }
+    if (m_resolution <= resolution) {
+        return pixClone(pix);
+    }
+    const l_float32 scale {static_cast<l_float32>(resolution) / m_resolution};
+    return pixScaleAreaMap(pix, scale, scale);
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
@@ -0,0 +1,64 @@
+#ifndef MRCENCODER_H
+#define MRCENCODER_H
+
+#include <vector>
+
+#include <leptonica/allheaders.h>
+
+// local
+#include "pdfwriter.h"
+
+/*
+    Mixed raster content encoding of a colour page.
+    The page is split into a full resolution 1 bpp text mask (G4 or JBIG2), a low resolution
+    jpeg background with the text removed and a very low resolution jpeg foreground
+    holding the colour of the text, which is drawn through the mask.
+    Photos are detected as halftone regions and kept in the background.
+*/
+class MrcEncoder {
+
+public:
+    MrcEncoder(Pix *pix, int resolution, bool useJbig2 = false);
+    ~MrcEncoder();
+    MrcEncoder(const MrcEncoder &) = delete;
+    MrcEncoder &operator=(const MrcEncoder &) = delete;
+
+    std::vector<PdfWriter::image> encode();
+
+private:
+    static constexpr int cBackgroundResolution = 150;
+    static constexpr int cForegroundResolution = 75;
+    static constexpr int cBackgroundQuality = 50;
+    static constexpr int cForegroundQuality = 40;
+    // Halftone detection of leptonica expects 150 - 200 ppi
+    static constexpr int cHalftoneResolution = 150;
+
+    Pix *m_pix {nullptr};
+    const int m_resolution;
+    const bool m_useJbig2;
+
+    Pix *textMask(Pix *pixGray) const;
+    PdfWriter::image background(Pix *pixBackground, Pix *mask) const;
+    PdfWriter::image textLayer(Pix *mask) const;
+    PdfWriter::image foreground(Pix *pixForeground, Pix *mask) const;
+    Pix *scaleTo(Pix *pix, int resolution) const;
+};
+
+#endif // MRCENCODER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,256 @@
+#include "pagehash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+/**
+ * Calculates the perceptual hash of a page.
+ * Pages which are not binary yet are thresholded first.
+ *
+ * @param pix The Pix object of the cleaned page.
+ *
+ * @throws None
+ */
+PageHash::PageHash(Pix *pix) {
+    if (pix == nullptr) {
+        return;
+    }
+
+    Pix *pixBinary {(pixGetDepth(pix) == 1) ? pixClone(pix) : pixConvertTo1(pix, 128)};
+    if (pixBinary == nullptr) {
+        return;
+    }
+
+    m_width = pixGetWidth(pixBinary);
+    m_height = pixGetHeight(pixBinary);
+    if (m_width < cGridWidth || m_height < cGridHeight) {
+        pixDestroy(&pixBinary);
+        return;
+    }
+
+    // A pixel of the copy reduced to half the size is black if any of its source pixels is black, thin strokes are kept
+    m_pixReduced = pixReduceRankBinaryCascade(pixBinary, 1, 0, 0, 0);
+    if (m_pixReduced == nullptr) {
+        pixDestroy(&pixBinary);
+        return;
+    }
+
+    // Number of black pixels in the bit range [start, end) of a line, the first pixel is the most significant bit
+    auto countBits = [](const l_uint32 *line, int start, int end) {
+        int count {0};
+        while (start < end) {
+            const int first = start % 32;
+            const int last = std::min(32, first + end - start);
+            l_uint32 mask = 0xFFFFFFFFu >> first;
+            if (last < 32) {
+                mask &= ~(0xFFFFFFFFu >> last);
+            }
+            count += __builtin_popcount(line[start / 32] & mask);
+            start += last - first;
+        }
+        return count;
+    };
+
+    std::array<int, cGridWidth + 1> columns;
+    for (int column = 0; column <= cGridWidth; column++) {
+        columns[column] = column * m_width / cGridWidth;
+    }
+
+    // Sum up the ink of every grid cell
+    std::array<double, cGridWidth * cGridHeight> ink {};
+    std::array<int, cGridHeight> rowsPerCell {};
+    const l_uint32 *data = pixGetData(pixBinary);
+    const int wpl = pixGetWpl(pixBinary);
+    double totalInk {0.0};
+
+    for (int y = 0; y < m_height; y++) {
+        const l_uint32 *line = data + static_cast<size_t>(y) * wpl;
+        const int row = y * cGridHeight / m_height;
+        rowsPerCell[row]++;
+        for (int column = 0; column < cGridWidth; column++) {
+            const int count = countBits(line, columns[column], columns[column + 1]);
+            ink[row * cGridWidth + column] += count;
+            totalInk += count;
+        }
+    }
+    pixDestroy(&pixBinary);
+
+    // Compare the ink density of horizontally neighbouring cells
+    auto density = [&](int row, int column) {
+        const double area = static_cast<double>(columns[column + 1] - columns[column]) * rowsPerCell[row];
+        return ink[row * cGridWidth + column] / area;
+    };
+
+    int bit {0};
+    for (int row = 0; row < cGridHeight; row++) {
+        for (int column = 0; column < cGridWidth - 1; column++, bit++) {
+            if (density(row, column) > density(row, column + 1)) {
+                m_bits[bit / 64] |= uint64_t {1} << (bit % 64);
+            }
+        }
+    }
+
+    m_ink = totalInk / (static_cast<double>(m_width) * m_height);
+    m_isValid = true;
+}
+
+PageHash::~PageHash() {
+    pixDestroy(&m_pixReduced);
+}
+
+/**
+ * Copies the hash. The reduced page is copied instead of cloned,
+ * leptonica's reference counting is not thread safe.
+ *
+ * @param other The hash to copy.
+ *
+ * @throws None
+ */
+PageHash::PageHash(const PageHash &other) : m_bits(other.m_bits), m_width(other.m_width), m_height(other.m_height),
+    m_ink(other.m_ink), m_isValid(other.m_isValid) {
+    if (other.m_pixReduced != nullptr) {
+        m_pixReduced = pixCopy(nullptr, other.m_pixReduced);
+    }
+}
+
+PageHash::PageHash(PageHash &&other) noexcept : m_bits(other.m_bits), m_width(other.m_width), m_height(other.m_height),
+    m_ink(other.m_ink), m_isValid(other.m_isValid), m_pixReduced(other.m_pixReduced) {
+    other.m_pixReduced = nullptr;
+    other.m_isValid = false;
+}
+
+PageHash &PageHash::operator=(PageHash other) noexcept {
+    std::swap(m_bits, other.m_bits);
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_ink, other.m_ink);
+    std::swap(m_isValid, other.m_isValid);
+    std::swap(m_pixReduced, other.m_pixReduced);
+    return *this;
+}
+
+/**
+ * Returns the number of differing bits between two hashes.
+ *
+ * @param other The hash to compare with.
+ *
+ * @return The Hamming distance of the hashes.
+ *
+ * @throws None
+ */
+int PageHash::distance(const PageHash &other) const {
+    int bits {0};
+    for (size_t i = 0; i < m_bits.size(); i++) {
+        bits += __builtin_popcountll(m_bits[i] ^ other.m_bits[i]);
+    }
+    return bits;
+}
+
+/**
+ * Checks whether two pages show the same content: same page size, nearly the same amount
+ * of ink, hashes which differ in only a few bits and reduced pages which are equal
+ * apart from the edges of the strokes.
+ *
+ * @param other The hash of the other page.
+ *
+ * @return True if both hashes are valid and the pages are duplicates, false otherwise.
+ *
+ * @throws None
+ */
+bool PageHash::isDuplicate(const PageHash &other) const {
+    if (!m_isValid || !other.m_isValid) {
+        return false;
+    }
+
+    auto differs = [](double a, double b, double tolerance) {
+        return std::abs(a - b) > tolerance * std::max(a, b);
+    };
+
+    if (differs(m_width, other.m_width, cMaxSizeDifference) || differs(m_height, other.m_height, cMaxSizeDifference)) {
+        return false;
+    }
+    if (differs(m_ink, other.m_ink, cMaxInkDifference)) {
+        return false;
+    }
+    return distance(other) <= cMaxDistance && hasSamePixels(other);
+}
+
+/**
+ * Compares the reduced pages pixel by pixel. The other page is shifted by up to cMaxShift pixels
+ * to the position with the fewest differing pixels. Differences only one pixel wide are
+ * scanning noise along the strokes and are removed by an opening, everything left over
+ * (a different digit or name) makes the pages different.
+ * The reduced pages are only read, so the other hash may be compared by several threads.
+ *
+ * @param other The hash of the other page.
+ *
+ * @return True if the pages are equal after alignment, false otherwise.
+ *
+ * @throws None
+ */
+bool PageHash::hasSamePixels(const PageHash &other) const {
+    if (m_pixReduced == nullptr || other.m_pixReduced == nullptr) {
+        return false;
+    }
+
+    const int width {pixGetWidth(m_pixReduced)};
+    const int height {pixGetHeight(m_pixReduced)};
+    Pix *pixShifted {pixCreate(width, height, 1)};
+    Pix *pixBest {nullptr};
+    l_int32 bestCount {width * height};
+
+    for (int dy = -cMaxShift; dy <= cMaxShift; dy++) {
+        for (int dx = -cMaxShift; dx <= cMaxShift; dx++) {
+            pixClearAll(pixShifted);
+            pixRasterop(pixShifted, dx, dy, pixGetWidth(other.m_pixReduced), pixGetHeight(other.m_pixReduced), PIX_SRC, other.m_pixReduced, 0, 0);
+            pixRasterop(pixShifted, 0, 0, width, height, PIX_SRC ^ PIX_DST, m_pixReduced, 0, 0);
+
+            l_int32 count {0};
+            pixCountPixels(pixShifted, &count, nullptr);
+            if (count < bestCount) {
+                bestCount = count;
+                pixDestroy(&pixBest);
+                pixBest = pixCopy(nullptr, pixShifted);
+            }
+        }
+    }
+    pixDestroy(&pixShifted);
+    if (pixBest == nullptr) {
+        return false;
+    }
+
+    // The borders are left out, the shift moves the other page partly out of the frame
+    Box *inner {boxCreate(cMaxShift, cMaxShift, width - 2 * cMaxShift, height - 2 * cMaxShift)};
+    Pix *pixInner {pixClipRectangle(pixBest, inner, nullptr)};
+    boxDestroy(&inner);
+    pixDestroy(&pixBest);
+    Pix *pixDifference {(pixInner != nullptr) ? pixOpenBrick(nullptr, pixInner, 2, 2) : nullptr};
+    pixDestroy(&pixInner);
+    if (pixDifference == nullptr) {
+        return false;
+    }
+
+    l_int32 differingPixels {0};
+    pixCountPixels(pixDifference, &differingPixels, nullptr);
+    pixDestroy(&pixDifference);
+    return differingPixels <= cMaxDifferingPixels;
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
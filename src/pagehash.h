@@ -0,0 +1,72 @@
+#ifndef PAGEHASH_H
+#define PAGEHASH_H
+
+#include <array>
+#include <cstdint>
+
+#include <leptonica/allheaders.h>
+
+/*
+    Perceptual difference hash (dHash) of a page.
+    The binary page is reduced to a grid of ink densities and every bit of the hash
+    tells whether a cell contains more ink than its right neighbour.
+    Pages whose hashes differ in only a few bits have the same layout. Pages of the same template
+    (invoices, forms, letterheads) do as well, so a match is confirmed on a reduced copy of the page:
+    after aligning both copies, they may differ only in isolated edge pixels.
+*/
+class PageHash {
+
+public:
+    PageHash() = default;
+    PageHash(Pix *pix);
+    ~PageHash();
+    PageHash(const PageHash &other);
+    PageHash(PageHash &&other) noexcept;
+    PageHash &operator=(PageHash other) noexcept;
+
+    bool isValid() const { return m_isValid; };
+    int distance(const PageHash &other) const;
+    bool isDuplicate(const PageHash &other) const;
+
+private:
+    static constexpr int cGridWidth = 33;
+    static constexpr int cGridHeight = 32;
+    static constexpr int cBits = (cGridWidth - 1) * cGridHeight;
+    // Maximum number of differing bits for pages to count as duplicates
+    static constexpr int cMaxDistance = cBits / 100;
+    // Maximum relative difference of the page size and the total ink
+    static constexpr double cMaxSizeDifference = 0.02;
+    static constexpr double cMaxInkDifference = 0.05;
+    // Largest shift between two scans of a page in pixels of the copy reduced to half the size
+    // and the number of pixels which may differ after removing the edges of the strokes
+    static constexpr int cMaxShift = 4;
+    static constexpr int cMaxDifferingPixels = 8;
+
+    std::array<uint64_t, cBits / 64> m_bits {};
+    int m_width {0};
+    int m_height {0};
+    double m_ink {0.0};
+    bool m_isValid {false};
+    Pix *m_pixReduced {nullptr};
+
+    bool hasSamePixels(const PageHash &other) const;
+};
+
+#endif // PAGEHASH_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
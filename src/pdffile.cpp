@@ -1,13 +1,30 @@
 #include "pdffile.h"
 #include "scan2ocr.h"
+#include "pixmemorypool.h"
+#include "mrcencoder.h"
+#include "mappedfile.h"
+#include "transfermanager.h"
+#include "listingsnapshot.h"
+#include "removalqueue.h"
+#include "claimmanager.h"
 
 // From https://github.com/bshoshany/thread-pool:
 #include "BS_thread_pool.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <regex>
 
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 /**
  * PdfFile constructor that initializes the object with the given URL, parent QObject, and document profile index.
  *
@@ -22,11 +39,13 @@
 PdfFile::PdfFile(ParseUrl Url, QObject *parent, int documentProfileIndex) : QObject(parent), m_Url(Url), m_parent(parent), m_documentProfileIndex(documentProfileIndex) {
     if (parent != nullptr) {
         #ifdef DEBUG
-            std::cout << "Connecting PdfFile::statusChange and finished (" << this << ") to parent (" << parent << ")" << std::endl;
+            std::cout << "Connecting PdfFile::statusChange, pagesWritten and finished (" << this << ") to parent (" << parent << ")" << std::endl;
         #endif
 
-        QObject::connect(this, SIGNAL(statusChange()), parent, SLOT(statusUpdate()), Qt::DirectConnection);
-        QObject::connect(this, SIGNAL(finished()), parent, SLOT(filesProcessed()), Qt::DirectConnection);
+        // The file is processed in the background, the parent handles the signals in its own thread
+        QObject::connect(this, SIGNAL(statusChange()), parent, SLOT(statusUpdate()), Qt::QueuedConnection);
+        QObject::connect(this, SIGNAL(pagesWritten(int)), parent, SLOT(previewUpdate(int)), Qt::QueuedConnection);
+        QObject::connect(this, SIGNAL(finished()), parent, SLOT(filesProcessed()), Qt::QueuedConnection);
     }
 
     // Set documentProfile
@@ -35,11 +54,26 @@ PdfFile::PdfFile(ParseUrl Url, QObject *parent, int documentProfileIndex) : QObj
     documentProfile.thresholdValue = settings.DocumentProfile(m_documentProfileIndex)->thresholdValue;
     documentProfile.resolution = settings.DocumentProfile(m_documentProfileIndex)->resolution;
     documentProfile.language = settings.DocumentProfile(m_documentProfileIndex)->language;
+    documentProfile.cropBorders = settings.DocumentProfile(m_documentProfileIndex)->cropBorders;
+    documentProfile.mixedRasterContent = settings.DocumentProfile(m_documentProfileIndex)->mixedRasterContent;
+    documentProfile.jbig2 = settings.DocumentProfile(m_documentProfileIndex)->jbig2;
+    documentProfile.linearized = settings.DocumentProfile(m_documentProfileIndex)->linearized;
+}
+
+PdfFile::~PdfFile() {
+    if (m_memoryFd >= 0) {
+        closeMemoryFile();
+    }
+    else if (!tempFileName.empty()) {
+        // Not renamed to its final name (exit, removed from the list), nobody else knows the unique name
+        std::remove(tempFileName.c_str());
+    }
 }
 
 /**
  * Initializes the PdfFile object by reading data from a local pdf file or from a remote server.
  * Has to be called after the constructor to have a valid object while emitting signals.
+ * May run on a background thread, finished is emitted in any case.
  * @throws None
  */
 void PdfFile::initialize() {
@@ -48,11 +82,68 @@ void PdfFile::initialize() {
         readData(readFile(&filename));
     }
     else {
-        std::unique_ptr<std::string> remoteFilePtr = ftpConnection.getFilePtr();
+        startDownload();
+        std::future<std::unique_ptr<std::string>> download;
+        {
+            const std::lock_guard<std::mutex> lock(m_downloadMutex);
+            download = std::move(m_download);
+        }
+        const auto waitStart {std::chrono::steady_clock::now()};
+        std::unique_ptr<std::string> remoteFilePtr = download.get();
+        m_downloadWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - waitStart).count();
         if (remoteFilePtr != nullptr) {
             readData(remoteFilePtr.get());
         }
     }
+    m_isFinished = true;
+    emit finished();
+}
+
+/**
+ * Queues the download of a remote file with the TransferManager, so it is transferred
+ * concurrently with other files before initialize needs it. Calling it again has no effect.
+ *
+ * @throws None
+ */
+void PdfFile::startDownload() {
+    if (!isRemote()) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(m_downloadMutex);
+    if (!m_isDownloadQueued) {
+        m_download = TransferManager::instance().download(m_Url, [this](size_t bytes) { m_downloadedBytes += bytes; });
+        m_isDownloadQueued = true;
+    }
+}
+
+/**
+ * Returns the server the file comes from, files of one source share its bandwidth.
+ *
+ * @return The user, host and port of a remote file, an empty string for a local file.
+ *
+ * @throws None
+ */
+std::string PdfFile::Source() const {
+    if (m_Url.Scheme() == "file") {
+        return std::string();
+    }
+    return m_Url.Username() + "@" + m_Url.Host() + ":" + std::to_string(m_Url.Port());
+}
+
+/**
+ * Checks whether the file can be processed without waiting for its download.
+ *
+ * @return true for a local file and for a remote file whose download completed.
+ *
+ * @throws None
+ */
+bool PdfFile::isDownloaded() {
+    if (!isRemote()) {
+        return true;
+    }
+    const std::lock_guard<std::mutex> lock(m_downloadMutex);
+    return m_isDownloadQueued && m_download.valid()
+           && m_download.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 }
 
 /**
@@ -116,18 +207,21 @@ void PdfFile::readData(const std::string *pdfData) {
         next++;
     }
 
+    // The output is about as large as the scanned file
+    openMemoryFile(pdfData->size());
     startPDF();
 
     // Extract every image stream
     NumberOfPages = imageStreamPositions.size();
 
-    BS::thread_pool threadPool;
+    // Pages are processed in parallel, the writer puts them back into order
+    BS::thread_pool threadPool(settings.OcrThreads());
     #define MULTITHREAD
 
     for (int i = 0; i < NumberOfPages; i++) {
     #ifdef MULTITHREAD
         threadPool.detach_task(
-            [&]
+            [this, pdfData, &imageStreamPositions, i]
             { 
     #endif
                 const size_t startPos = imageStreamPositions[i];
@@ -145,59 +239,108 @@ void PdfFile::readData(const std::string *pdfData) {
                     *jpgImage = jpgImage->substr(match.position(1) + startCharacters);    
                     processImage(jpgImage, i);
                 }
+                else {
+                    writer->skipPage(i);
+                }
                 delete jpgImage;
                 jpgImage = nullptr;
             
     #ifdef MULTITHREAD
             }
         );
-        threadPool.wait(); 
     #endif
     }
+    #ifdef MULTITHREAD
+        threadPool.wait();
+    #endif
 
     endPDF();
-    emit finished();
 }
 
 /**
  * Initializes the PDF file for OCR processing.
  *
- * This function sets up the OCR engine with the appropriate language and page segmentation mode.
- * It also creates a TessPDFRenderer object with the specified output base, Tesseract data path,
- * and text-only flag. Finally, it begins the document with the specified title.
+ * This function selects the ocr language, initializes the first OCR engine and creates
+ * the PdfWriter with the glyphless font of the Tesseract data path. Finally, it begins
+ * the document with the specified title.
+ * The PdfWriter replaces TessPDFRenderer, which encodes and writes every page on the calling
+ * thread and embeds exactly one re-encoded image per page.
  *
  * @return void
  *
  * @throws None
  */
 void PdfFile::startPDF() {
-    std::string language;
     switch (documentProfile.language) {
         case Settings::Language::deu:
-            language = "deu";
+            m_language = "deu";
             break;
         case Settings::Language::eng:
-            language = "eng";
+            m_language = "eng";
             break;
         default:
             // Handle unknown language
             break;
     }
-    ocr.Init(NULL, language.c_str());
-    ocr.SetPageSegMode(tesseract::PageSegMode::PSM_AUTO);
 
-    const std::string outputBaseStr {tempFileName.substr(0, tempFileName.length() - 4)};
-    const char  *outputBase = outputBaseStr.c_str();
-    const char *tesseractDataPath {ocr.GetDatapath()};
-    const bool textonly {false};    
-    renderer = std::make_unique<tesseract::TessPDFRenderer>(outputBase, tesseractDataPath, textonly);
-    
-    const char *documentTitle = m_Url.Filename().c_str();
-    renderer->BeginDocument(documentTitle);
+    // The glyphless font of the text layer is shipped with the tesseract data
+    tesseract::TessBaseAPI *api {acquireOcrEngine()};
+    const std::string fontFileName {std::string(api->GetDatapath()) + "/pdf.ttf"};
+    releaseOcrEngine(api);
+
+    if (m_memoryFd < 0) {
+        tempFileName = createStagingFile(settings.DestinationDir().toStdString(), m_Url.Filename());
+    }
+
+    writer = std::make_unique<PdfWriter>(tempFileName, fontFileName);
+    writer->setPageWrittenCallback([this](int pageCount) { emit pagesWritten(pageCount); });
+    writer->setLinearized(documentProfile.linearized);
+    writer->beginDocument(m_Url.Filename());
+    m_isWriting = true;
+}
+
+/**
+ * Hands out an idle ocr engine or initializes a new one if all engines are in use.
+ * There are never more engines than pages processed in parallel.
+ *
+ * @return The ocr engine, to be given back with releaseOcrEngine.
+ *
+ * @throws None
+ */
+tesseract::TessBaseAPI *PdfFile::acquireOcrEngine() {
+    tesseract::TessBaseAPI *api {nullptr};
+    {
+        const std::lock_guard<std::mutex> lock(m_ocrEnginesMutex);
+        if (!m_idleOcrEngines.empty()) {
+            api = m_idleOcrEngines.back();
+            m_idleOcrEngines.pop_back();
+            return api;
+        }
+        m_ocrEngines.push_back(std::make_unique<tesseract::TessBaseAPI>());
+        api = m_ocrEngines.back().get();
+    }
+
+    // Loading the language model takes a while, other workers are not blocked meanwhile
+    api->Init(NULL, m_language.c_str());
+    api->SetPageSegMode(tesseract::PageSegMode::PSM_AUTO);
+    return api;
+}
+
+/**
+ * Gives an ocr engine back for the next page.
+ *
+ * @param api The engine returned by acquireOcrEngine.
+ *
+ * @throws None
+ */
+void PdfFile::releaseOcrEngine(tesseract::TessBaseAPI *api) {
+    const std::lock_guard<std::mutex> lock(m_ocrEnginesMutex);
+    m_idleOcrEngines.push_back(api);
 }
 
 /**
  * Processes an image (which will be one page of a PDF file) by reading it from a string.
+ * Called concurrently for different pages by the worker threads.
  *
  * @param imageStringData A pointer to a string containing the image data.
  * @param page The page number of the image.
@@ -206,35 +349,76 @@ void PdfFile::startPDF() {
  */
 void PdfFile::processImage (const std::string *imageStringData, int page) {
     
-    // First create l_uint8 from std::string
-    const l_uint8 *l_uint8Ptr = (const unsigned char *) imageStringData->c_str();
-    size_t length {imageStringData->size()};
-    
-    Pix *pix {pixReadMem(l_uint8Ptr, length)};
+    // Decode the jpg image, large images with restart markers are decoded in parallel bands
+    JpegDecoder jpegDecoder(imageStringData);
+    Pix *pix {jpegDecoder.decode()};
     myProgress = timeConstants::MEMORY;
     emit statusChange();
 
     if (!isEmptyPage(pix)) {
             transcode(pix);
-            ocrPage(pix, page);
 
-        if (page == 0) {
-            getFileName();
-        }   
+            // Restrict ocr to the content of the page, scanner borders and punch holes of binary pages are whitened
+            Box *contentBox {findContentBox(pix)};
+
+            // The page images are encoded while the page is recognized
+            std::future<std::vector<PdfWriter::image>> pageImages {encodePageImages(pix, imageStringData, jpegDecoder)};
+
+            // A repeated page (e.g. double feed) reuses the text layer of the page recognized before,
+            // the first page is always recognized for the file name
+            PageHash pageHash(pix);
+            std::string text;
+            if (page == 0 || !reuseOcrPage(pageHash, text)) {
+                tesseract::TessBaseAPI *api {acquireOcrEngine()};
+                text = ocrPage(api, pix, page, contentBox);
+                if (page == 0) {
+                    getFileName(api);
+                }
+                releaseOcrEngine(api);
+
+                const std::lock_guard<std::mutex> lock(m_recognizedPagesMutex);
+                m_recognizedPages.push_back({std::move(pageHash), text});
+                if (m_recognizedPages.size() > cRecognizedPages) {
+                    m_recognizedPages.pop_front();
+                }
+            }
+            addPage(pix, page, pageImages, std::move(text));
+            boxDestroy(&contentBox);
+    }
+    else {
+        writer->skipPage(page);
     }
 
     pixDestroy(&pix);
 }
 
 /**
- * Ends the PDF document by calling the EndDocument method of the renderer object and
- * the End method of the OCR object.
+ * Ends the PDF document by calling the endDocument method of the writer object and
+ * the End method of the OCR engines.
  *
  * @throws None
  */
 void PdfFile::endPDF() {
-    renderer->EndDocument();
-    ocr.End();
+    writer->endDocument();
+    finishMemoryFile();
+    for (auto &api : m_ocrEngines) {
+        api->End();
+    }
+    m_ocrEngines.clear();
+    m_idleOcrEngines.clear();
+
+    #ifdef DEBUG
+        if (m_pageArea > 0) {
+            std::cout << "PdfFile::endPDF: recognized " << 100 * m_recognizedArea / m_pageArea << "% of the page area" << std::endl;
+        }
+        std::cout << "PdfFile::endPDF: " << m_duplicatePages << " duplicate pages of " << NumberOfPages << " not recognized again" << std::endl;
+        if (m_bilevelEncodedBytes > 0) {
+            std::cout << "PdfFile::endPDF: binary pages compressed " << (documentProfile.jbig2 ? "JBIG2" : "G4") << " by "
+                      << static_cast<double>(m_bilevelRawBytes) / m_bilevelEncodedBytes << ":1 in "
+                      << m_bilevelEncodeTime / 1000 << " ms" << std::endl;
+        }
+        PixMemoryPool::instance().printStatistics();
+    #endif
 }
 
 /**
@@ -291,39 +475,312 @@ bool PdfFile::isEmptyPage(Pix *pix) {
 void PdfFile::transcode(Pix *&pix) {
 
         if (!documentProfile.isColored) {
-            pix = pixCleanImage(pix, 5, 0, 1, 0);
+            Pix *pixClean {pixCleanImage(pix, 5, 0, 1, 0)};
+            if (pixClean != nullptr) {
+                pixDestroy(&pix);
+                pix = pixClean;
+            }
         }
         myProgress = timeConstants::TRANSCODE;
         emit statusChange();
 }
 
 /**
- * Sets the image for OCR processing, recognizes the text, and adds the image to the renderer. 
+ * Finds the bounding box of the page content after binarisation and removes scanner
+ * borders and punch holes from binary pages.
+ * A scanner border touches the image edge and lies completely within cBorderZone of the
+ * edges, like the black frame or shadow of the scanner lid. Lines of tables or frames
+ * running to the edge reach further into the page and are kept. A punch hole is a solid
+ * round blob of hole size near an edge, round glyphs are rings and do not fill their box.
+ * Only the pixels of these components are whitened, everything else on the page is kept,
+ * also outside the content box, which only restricts the ocr.
  *
+ * @param pix The Pix object of the transcoded page, scanner borders and punch holes are removed if it is binary.
+ *
+ * @return The content box including a small margin, nullptr if cropping is disabled,
+ *  the page has no content or the content covers nearly the whole page.
+ *
+ * @throws None
+ */
+Box *PdfFile::findContentBox(Pix *pix) {
+    if (!documentProfile.cropBorders || pix == nullptr) {
+        return nullptr;
+    }
+
+    const int width {pixGetWidth(pix)};
+    const int height {pixGetHeight(pix)};
+    const int resolution {pixGetXRes(pix) > 0 ? pixGetXRes(pix) : documentProfile.resolution};
+    auto millimeters = [resolution](double mm) { return static_cast<int>(mm * resolution / 25.4); };
+
+    // Punch holes have a diameter of 5 - 6 mm and sit within 25 mm of an edge
+    const int minHole {millimeters(4.0)};
+    const int maxHole {millimeters(8.0)};
+    const int edgeZone {millimeters(25.0)};
+    const int borderZone {millimeters(cBorderZone)};
+    const int margin {millimeters(3.0)};
+    const bool isBinary {pixGetDepth(pix) == 1};
+
+    Pix *pixBinary {isBinary ? pixClone(pix) : pixConvertTo1(pix, 128)};
+    Pixa *components {nullptr};
+    Boxa *boxa {pixConnComp(pixBinary, &components, 8)};
+    pixDestroy(&pixBinary);
+    boxaDestroy(&boxa);
+    if (components == nullptr) {
+        return nullptr;
+    }
+
+    int left {width}, top {height}, right {0}, bottom {0};
+    for (int i = 0; i < pixaGetCount(components); i++) {
+        int x, y, w, h;
+        pixaGetBoxGeometry(components, i, &x, &y, &w, &h);
+
+        // Single specks
+        if (w < 3 && h < 3) {
+            continue;
+        }
+
+        Pix *component {pixaGetPix(components, i, L_CLONE)};
+        bool isRemoved {isScannerBorder(component, x, y, width, height, borderZone)};
+        const bool isRound {w >= minHole && w <= maxHole && h >= minHole && h <= maxHole && 4 * w >= 3 * h && 4 * h >= 3 * w};
+        const bool isAtEdge {x < edgeZone || y < edgeZone || x + w > width - edgeZone || y + h > height - edgeZone};
+        if (!isRemoved && isRound && isAtEdge) {
+            // A filled circle covers 79 % of its box
+            int count {0};
+            pixCountPixels(component, &count, nullptr);
+            isRemoved = (10 * static_cast<int64_t>(count) >= 6 * static_cast<int64_t>(w) * h);
+        }
+        if (isRemoved && isBinary) {
+            pixRasterop(pix, x, y, w, h, PIX_SUBTRACT, component, 0, 0);
+        }
+        pixDestroy(&component);
+        if (isRemoved) {
+            continue;
+        }
+
+        left = std::min(left, x);
+        top = std::min(top, y);
+        right = std::max(right, x + w);
+        bottom = std::max(bottom, y + h);
+    }
+    pixaDestroy(&components);
+
+    // No content at all
+    if (right <= left || bottom <= top) {
+        return nullptr;
+    }
+
+    left = std::max(0, left - margin);
+    top = std::max(0, top - margin);
+    right = std::min(width, right + margin);
+    bottom = std::min(height, bottom + margin);
+
+    // Not worth cropping
+    const double contentFraction {static_cast<double>(right - left) * (bottom - top) / (static_cast<double>(width) * height)};
+    if (contentFraction > 0.98) {
+        return nullptr;
+    }
+
+    return boxCreate(left, top, right - left, bottom - top);
+}
+
+/**
+ * Checks whether a connected component is a scanner border: it touches the image edge
+ * and has no pixels further from the edges than the border zone.
+ *
+ * @param component The pixels of the component.
+ * @param x The left edge of the component on the page.
+ * @param y The top edge of the component on the page.
+ * @param width The width of the page.
+ * @param height The height of the page.
+ * @param borderZone The width of the zone along the edges in pixels.
+ *
+ * @return true if the component is a scanner border.
+ *
+ * @throws None
+ */
+bool PdfFile::isScannerBorder(Pix *component, int x, int y, int width, int height, int borderZone) {
+    const int w {pixGetWidth(component)};
+    const int h {pixGetHeight(component)};
+    if (x > 0 && y > 0 && x + w < width && y + h < height) {
+        return false;
+    }
+
+    // The part of the component inside the page, away from the border zone
+    const int innerLeft {std::max(x, borderZone)};
+    const int innerTop {std::max(y, borderZone)};
+    const int innerRight {std::min(x + w, width - borderZone)};
+    const int innerBottom {std::min(y + h, height - borderZone)};
+    if (innerRight <= innerLeft || innerBottom <= innerTop) {
+        return true;
+    }
+
+    Box *innerBox {boxCreate(innerLeft - x, innerTop - y, innerRight - innerLeft, innerBottom - innerTop)};
+    Pix *inner {pixClipRectangle(component, innerBox, nullptr)};
+    boxDestroy(&innerBox);
+    int isEmpty {0};
+    if (inner != nullptr) {
+        pixZero(inner, &isEmpty);
+        pixDestroy(&inner);
+    }
+    return isEmpty != 0;
+}
+
+/**
+ * Sets the image for OCR processing, recognizes the text and creates the text layer of the page.
+ *
+ * @param api The ocr engine of the calling worker.
  * @param pix Pointer to the Pix object representing the image.
  * @param page The page number to be processed.
+ * @param contentBox The region of the page to be recognized, the whole page if nullptr.
  *
- * @return None
+ * @return The text layer for the writer.
  *
  * @throws None
  * 
  * 
  */
-void PdfFile::ocrPage(Pix *pix, int page) {
-    ocr.SetImage(pix);
+std::string PdfFile::ocrPage(tesseract::TessBaseAPI *api, Pix *pix, int page, Box *contentBox) {
+    api->SetImage(pix);
+
+    // The page keeps the whole image, only the recognition is restricted to the content
+    m_pageArea += static_cast<size_t>(pixGetWidth(pix)) * pixGetHeight(pix);
+    if (contentBox != nullptr) {
+        int x, y, w, h;
+        boxGetGeometry(contentBox, &x, &y, &w, &h);
+        api->SetRectangle(x, y, w, h);
+        m_recognizedArea += static_cast<size_t>(w) * h;
+    }
+    else {
+        m_recognizedArea += static_cast<size_t>(pixGetWidth(pix)) * pixGetHeight(pix);
+    }
 
     tesseract::ETEXT_DESC monitor;
     bool failed {true};
 
-    std::thread recognize_thread(std::bind(&PdfFile::ocrProcess, this, &ocr, &monitor));
+    std::thread recognize_thread(std::bind(&PdfFile::ocrProcess, this, api, &monitor));
     std::thread monitor_thread(std::bind(&PdfFile::monitorProgress, this, &monitor, page)); 
     recognize_thread.join();
     monitor_thread.join();
 
-    renderer->AddImage(&ocr);
+    const int resolution {pixGetYRes(pix) > 0 ? pixGetYRes(pix) : documentProfile.resolution};
+    std::string text {PdfWriter::textLayer(api, pixGetHeight(pix), resolution)};
+
+    myProgress = timeConstants::OCR;
+    emit statusChange();
+    return text;
+}
+
+/**
+ * Looks for a recently recognized page of the document with the same content
+ * and takes over its text layer instead of recognizing the page again.
+ * The newest pages are compared first, a double feed repeats the page before.
+ *
+ * @param pageHash The hash of the page to be added.
+ * @param text Receives the text layer of the recognized page.
+ *
+ * @return True if a duplicate has been found, false if the page has to be recognized.
+ *
+ * @throws None
+ */
+bool PdfFile::reuseOcrPage(const PageHash &pageHash, std::string &text) {
+    {
+        const std::lock_guard<std::mutex> lock(m_recognizedPagesMutex);
+        const auto duplicate = std::find_if(m_recognizedPages.rbegin(), m_recognizedPages.rend(),
+            [&pageHash](const recognizedPage &recognized) { return pageHash.isDuplicate(recognized.hash); });
+        if (duplicate == m_recognizedPages.rend()) {
+            return false;
+        }
+        text = duplicate->text;
+    }
+    m_duplicatePages++;
+
+    #ifdef DEBUG
+        std::cout << "PdfFile::reuseOcrPage: reused the recognition result for a duplicate page of " << m_Url.Filename() << std::endl;
+    #endif
 
     myProgress = timeConstants::OCR;
     emit statusChange();
+    return true;
+}
+
+/**
+ * Provides the images of a colored page for the writer.
+ * Without mixed raster content the original JPEG data is embedded unchanged, as long as the
+ * page has the geometry of the JPEG image. Otherwise the mixed raster content layers
+ * are encoded in the background.
+ *
+ * @param pix Pointer to the Pix object representing the colored page.
+ * @param jpegData The JPEG data the page has been decoded from.
+ * @param jpegDecoder The decoder holding the header information of the JPEG data.
+ *
+ * @return The future of the page images in drawing order, invalid if the page has to be encoded as a whole.
+ *
+ * @throws None
+ */
+std::future<std::vector<PdfWriter::image>> PdfFile::encodePageImages(Pix *pix, const std::string *jpegData, const JpegDecoder &jpegDecoder) {
+    if (!documentProfile.isColored) {
+        return std::future<std::vector<PdfWriter::image>>();
+    }
+    if (!documentProfile.mixedRasterContent) {
+        const bool isUnchanged {pixGetWidth(pix) == jpegDecoder.Width() && pixGetHeight(pix) == jpegDecoder.Height()};
+        if (jpegDecoder.isPdfCompatible() && isUnchanged) {
+            std::promise<std::vector<PdfWriter::image>> passthrough;
+            passthrough.set_value({PdfWriter::jpegImage(*jpegData, jpegDecoder.Width(), jpegDecoder.Height(), jpegDecoder.Components())});
+            return passthrough.get_future();
+        }
+        return std::future<std::vector<PdfWriter::image>>();
+    }
+
+    const int resolution {pixGetXRes(pix) > 0 ? pixGetXRes(pix) : documentProfile.resolution};
+
+    // The encoder gets a copy of its own, leptonica's reference counting is not thread safe
+    Pix *pixPage {pixCopy(nullptr, pix)};
+    return std::async(std::launch::async, [pixPage, resolution, useJbig2 = documentProfile.jbig2]() mutable {
+        MrcEncoder encoder(pixPage, resolution, useJbig2);
+        pixDestroy(&pixPage);
+        return encoder.encode();
+    });
+}
+
+/**
+ * Finishes a page and hands it to the writer, which appends it in page order.
+ *
+ * @param pix Pointer to the Pix object representing the page.
+ * @param page The page number.
+ * @param pageImages The encoded page images, the whole page is embedded as one image
+ *  (JBIG2 or G4 for binary pages) if they are missing.
+ * @param text The text layer of the page.
+ *
+ * @return None
+ *
+ * @throws None
+ */
+void PdfFile::addPage(Pix *pix, int page, std::future<std::vector<PdfWriter::image>> &pageImages, std::string &&text) {
+    const int resolution {pixGetYRes(pix) > 0 ? pixGetYRes(pix) : documentProfile.resolution};
+    PdfWriter::page pdfPage;
+    pdfPage.width = 72.0 * pixGetWidth(pix) / resolution;
+    pdfPage.height = 72.0 * pixGetHeight(pix) / resolution;
+    if (pageImages.valid()) {
+        pdfPage.images = pageImages.get();
+    }
+    if (pdfPage.images.empty() && pixGetDepth(pix) == 1) {
+        const auto start {std::chrono::steady_clock::now()};
+        if (documentProfile.jbig2) {
+            pdfPage.images.push_back(PdfWriter::jbig2Image(pix));
+        }
+        if (pdfPage.images.empty() || pdfPage.images.front().data.empty()) {
+            pdfPage.images.assign(1, PdfWriter::encodeImage(pix, L_G4_ENCODE));
+        }
+        m_bilevelEncodeTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        m_bilevelRawBytes += static_cast<size_t>(pixGetWpl(pix)) * 4 * pixGetHeight(pix);
+        m_bilevelEncodedBytes += pdfPage.images.front().data.size();
+    }
+    if (pdfPage.images.empty()) {
+        pdfPage.images.push_back(PdfWriter::encodeImage(pix, L_JPEG_ENCODE));
+    }
+    pdfPage.text = std::move(text);
+
+    writer->addPage(page, std::move(pdfPage));
 }
 
 void PdfFile::ocrProcess(tesseract::TessBaseAPI *ocr, tesseract::ETEXT_DESC *monitor) {
@@ -351,6 +808,9 @@ void PdfFile::monitorProgress(tesseract::ETEXT_DESC *monitor, int page) {
             }
         }
         if (monitorProgress >= 100 || monitorProgress < 0) break;
+
+        // Polling without a pause would take a core from the parallel recognition of the other pages
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
     }
 
 }
@@ -371,7 +831,7 @@ void PdfFile::monitorProgress(tesseract::ETEXT_DESC *monitor, int page) {
  *
  * @throws None
  */
-void PdfFile::getFileName() {
+void PdfFile::getFileName(tesseract::TessBaseAPI *api) {
 
     // Check for the largest line of text which does not end with a "." character and has more than 2 characters,
     // which hopefully will be in the majority of cases some descriptive filename
@@ -379,7 +839,7 @@ void PdfFile::getFileName() {
     double largestFontSize {0.0};
     std::string lineWithLargestFontSize {""};
 
-    tesseract::ResultIterator *resultIterator = ocr.GetIterator();
+    tesseract::ResultIterator *resultIterator = api->GetIterator();
     // Loop through the iterator and get results at word level, calculate bounding box height and fontsize
     tesseract::PageIteratorLevel level = tesseract::RIL_TEXTLINE;
     resultIterator->Begin();
@@ -483,17 +943,20 @@ bool PdfFile::removeFile() {
         #endif
     }
     else {
-        FtpConnection ftpConnection (m_Url);
         #ifdef DEBUG
             std::cout << "PdfFile::removeFile: removing file: " << m_Url.Url() << std::endl;
         #else
-            if (!ftpConnection.deleteFile()) {
-                QMessageBox::critical(nullptr, tr("Error"), QString(tr("Error deleting file ")) + QString::fromStdString(m_Url.FileDir()));
-                return false;
-            }
+            // Removed in the background, errors are retried there
+            RemovalQueue::instance().remove(m_Url);
         #endif
     }
-    std::remove(tempFileName.c_str());
+    if (m_memoryFd >= 0) {
+        closeMemoryFile();
+    }
+    else if (!tempFileName.empty()) {
+        std::remove(tempFileName.c_str());
+        tempFileName.clear();
+    }
     return true;
 }
 
@@ -504,49 +967,378 @@ bool PdfFile::removeFile() {
  *
  * @return true if the file was successfully renamed, false otherwise.
  *
- * @throws std::filesystem::filesystem_error if there are errors during file copying or removal.
+ * @throws None
  */
 bool PdfFile::renameToFileName(const std::string fileName) {
-    std::filesystem::copy_options options = std::filesystem::copy_options::none;
     if (std::filesystem::exists(fileName)) {
         QMessageBox::StandardButton reply;
         reply = QMessageBox::question(nullptr, tr("Warning"), QString(tr("File already exists, overwrite?")), QMessageBox::Yes | QMessageBox::No);
         if (reply == QMessageBox::No) {
             return false;
         } 
+    } 
+
+    // Replaces an existing file atomically. The linearized layout is written here, by the
+    // write that stores the file under its final name, the output is not written twice.
+    if (documentProfile.linearized && writeLinearizedFile(fileName)) {
+        if (m_memoryFd >= 0) {
+            closeMemoryFile();
+        }
         else {
-            // It should be overwritten
-            options = std::filesystem::copy_options::overwrite_existing;
+            std::remove(tempFileName.c_str());
+            tempFileName.clear();
         }
-    } 
+    }
+    else if (m_memoryFd >= 0) {
+        if (!copyToFile(m_memoryFd, fileName)) {
+            return false;
+        }
+        closeMemoryFile();
+    }
+    else if (!moveFile(tempFileName, fileName)) {
+        return false;
+    }
+    else {
+        tempFileName.clear();
+    }
+
+    return std::filesystem::exists(fileName);
+}
+
+/**
+ * Creates the file the pdf is written to before it gets its final name.
+ * The file is hidden in the destination directory, which in most cases is on the same
+ * filesystem as the final file. The temp directory is used if the destination directory
+ * is not writable.
+ * The process id and a counter keep the names of this process apart, O_EXCL those of other
+ * instances sharing the directory, so scans of the same name from different sources or
+ * subdirectories never write the same file.
+ *
+ * @param directory The destination directory.
+ * @param fileName The name of the scanned file.
+ *
+ * @return The full path of the empty staging file, empty if it could not be created.
+ *
+ * @throws None
+ */
+std::string PdfFile::createStagingFile(std::string directory, const std::string &fileName) {
+    if (!directory.empty() && directory.back() != '/') {
+        directory += "/";
+    }
+    if (directory.empty() || access(directory.c_str(), W_OK) != 0) {
+        directory = std::filesystem::temp_directory_path().string() + "/";
+    }
+
+    for (int attempt = 0; attempt < cStagingAttempts; attempt++) {
+        const std::string stagingName {directory + "." + fileName + "." + std::to_string(getpid()) + "-" +
+            std::to_string(s_stagingCounter++) + ".scan2ocr.part"};
+        const int fd {open(stagingName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666)};
+        if (fd >= 0) {
+            close(fd);
+            return stagingName;
+        }
+        if (errno != EEXIST) {
+            std::cerr << "Error creating " << stagingName << " because: " << std::strerror(errno) << std::endl;
+            return std::string();
+        }
+    }
+    return std::string();
+}
+
+/**
+ * Moves a file by rename(2). Across filesystems the data is cloned (FICLONE) or copied
+ * inside the kernel (copy_file_range) to a hidden file next to the target, which is then
+ * renamed to the target, so the target never exists partially written.
+ *
+ * @param source The file to move.
+ * @param target The new name of the file, an existing file is replaced.
+ *
+ * @return true if the file has been moved, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfFile::moveFile(const std::string &source, const std::string &target) {
+    if (std::rename(source.c_str(), target.c_str()) == 0) {
+        return true;
+    }
+    if (errno != EXDEV) {
+        std::cerr << "Error renaming " << source << " to " << target << " because: " << std::strerror(errno) << std::endl;
+        return false;
+    }
 
-    // Because the destination file can be on another filesystem we cannot use std::filesystem::rename
-    try {
-        std::filesystem::copy(tempFileName.c_str(), fileName.c_str(), options);    
+    const int sourceFd {open(source.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (sourceFd < 0) {
+        std::cerr << "Error opening " << source << " because: " << std::strerror(errno) << std::endl;
+        return false;
     }
-    catch (const std::filesystem::filesystem_error& ex) {
-        std::cerr << "Error copying temp file to " << fileName << " because: " << ex.what() << std::endl;
+    const bool success {copyToFile(sourceFd, target)};
+    close(sourceFd);
+    if (!success) {
         return false;
     }
-    if (!std::filesystem::remove(tempFileName.c_str())) {
+
+    if (std::remove(source.c_str()) != 0) {
         std::cerr << "Error removing temp file." << std::endl;
+    }
+    return true;
+}
+
+/**
+ * Writes the content of an open file to a hidden file next to the target, which is then
+ * renamed to the target, so the target never exists partially written.
+ *
+ * @param sourceFd The file descriptor of the source, its file position is not used.
+ * @param target The name of the file to write, an existing file is replaced.
+ *
+ * @return true if the file has been written, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfFile::copyToFile(int sourceFd, const std::string &target) {
+    const std::filesystem::path targetPath {target};
+    const std::string staging {createStagingFile(targetPath.parent_path().string(), targetPath.filename().string())};
+    if (staging.empty()) {
         return false;
-    };
+    }
 
-    return std::filesystem::exists(fileName);
+    const int targetFd {open(staging.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC)};
+    if (targetFd < 0) {
+        std::cerr << "Error opening " << staging << " because: " << std::strerror(errno) << std::endl;
+        std::remove(staging.c_str());
+        return false;
+    }
+
+    bool success {lseek(sourceFd, 0, SEEK_SET) == 0 && copyFileData(sourceFd, targetFd)};
+    // The data has to be on disk before the rename makes it visible
+    success = success && fsync(targetFd) == 0;
+    success = (close(targetFd) == 0) && success;
+
+    if (!success || std::rename(staging.c_str(), target.c_str()) != 0) {
+        std::cerr << "Error writing " << target << " because: " << std::strerror(errno) << std::endl;
+        std::remove(staging.c_str());
+        return false;
+    }
+    return true;
 }
 
 /**
- * Returns the file content as a shared pointer.
+ * Creates the output file in memory (memfd) if the estimated size fits into the memory
+ * left for output files. Otherwise the output stays on disk.
+ * The renderer, the preview and the final move all use the memory file by its
+ * /proc/self/fd path.
+ *
+ * @param estimatedSize The expected size of the output file in bytes.
+ *
+ * @throws None
+ */
+void PdfFile::openMemoryFile(size_t estimatedSize) {
+    const size_t limit {static_cast<size_t>(settings.MemoryFileLimit()) * 1024 * 1024};
+    if (limit == 0 || !reserveMemory(estimatedSize, limit)) {
+        return;
+    }
+
+    m_memoryFd = memfd_create(m_Url.Filename().c_str(), MFD_CLOEXEC);
+    if (m_memoryFd < 0) {
+        std::cerr << "Error creating memory file because: " << std::strerror(errno) << std::endl;
+        s_memoryFileBytes -= estimatedSize;
+        return;
+    }
+    m_memoryFileSize = estimatedSize;
+    tempFileName = "/proc/self/fd/" + std::to_string(m_memoryFd);
+}
+
+/**
+ * Accounts the real size of the finished memory file. If it does not fit into the memory
+ * left for output files, the file is moved to disk.
+ *
+ * @throws None
+ */
+void PdfFile::finishMemoryFile() {
+    if (m_memoryFd < 0) {
+        return;
+    }
+
+    struct stat fileStat;
+    const size_t size {(fstat(m_memoryFd, &fileStat) == 0) ? static_cast<size_t>(fileStat.st_size) : 0};
+    s_memoryFileBytes -= m_memoryFileSize;
+    m_memoryFileSize = 0;
+    const size_t limit {static_cast<size_t>(settings.MemoryFileLimit()) * 1024 * 1024};
+    if (reserveMemory(size, limit)) {
+        m_memoryFileSize = size;
+        return;
+    }
+
+    // Memory budget exceeded, the preview must not open the memory file meanwhile
+    const std::lock_guard<std::mutex> lock(m_tempFileMutex);
+    const std::string diskFileName {createStagingFile(settings.DestinationDir().toStdString(), m_Url.Filename())};
+    if (!diskFileName.empty() && copyToFile(m_memoryFd, diskFileName)) {
+        #ifdef DEBUG
+            std::cout << "PdfFile::finishMemoryFile: " << size << " bytes exceed the memory limit, moved to " << diskFileName << std::endl;
+        #endif
+        closeMemoryFile();
+        tempFileName = diskFileName;
+    }
+    else {
+        if (!diskFileName.empty()) {
+            std::remove(diskFileName.c_str());
+        }
+        // Keep the file in memory rather than losing it
+        s_memoryFileBytes += size;
+        m_memoryFileSize = size;
+    }
+}
+
+/**
+ * Writes the linearized document of the writer to a hidden file next to the target, which
+ * is then renamed to the target. The document written in page order is the source, it is
+ * read once and stays unchanged.
+ *
+ * @param target The name of the file to write, an existing file is replaced.
+ *
+ * @return true if the file has been written, false if the document has no pages or writing failed.
+ *
+ * @throws None
+ */
+bool PdfFile::writeLinearizedFile(const std::string &target) {
+    const std::filesystem::path targetPath {target};
+    const std::string staging {createStagingFile(targetPath.parent_path().string(), targetPath.filename().string())};
+    if (staging.empty()) {
+        return false;
+    }
+
+    bool success {writer->writeLinearized(tempFileName, staging)};
+    // The data has to be on disk before the rename makes it visible
+    const int targetFd {success ? open(staging.c_str(), O_WRONLY | O_CLOEXEC) : -1};
+    success = success && targetFd >= 0 && fsync(targetFd) == 0;
+    if (targetFd >= 0) {
+        success = (close(targetFd) == 0) && success;
+    }
+
+    if (!success || std::rename(staging.c_str(), target.c_str()) != 0) {
+        std::remove(staging.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Releases the memory file and its share of the memory for output files.
+ *
+ * @throws None
+ */
+void PdfFile::closeMemoryFile() {
+    if (m_memoryFd < 0) {
+        return;
+    }
+    close(m_memoryFd);
+    m_memoryFd = -1;
+    s_memoryFileBytes -= m_memoryFileSize;
+    m_memoryFileSize = 0;
+}
+
+/**
+ * Reserves memory for an output file from the memory shared by all output files.
+ *
+ * @param size The number of bytes to reserve.
+ * @param limit The memory for all output files in bytes.
+ *
+ * @return true if the memory has been reserved, false if it would exceed the limit.
+ *
+ * @throws None
+ */
+bool PdfFile::reserveMemory(size_t size, size_t limit) {
+    size_t used {s_memoryFileBytes};
+    do {
+        if (used + size > limit) {
+            return false;
+        }
+    } while (!s_memoryFileBytes.compare_exchange_weak(used, used + size));
+    return true;
+}
+
+/**
+ * Copies the whole content of one file to another, preferring a reflink (shared extents)
+ * and an in-kernel copy over reading the data into user space.
+ *
+ * @param sourceFd The file descriptor of the source, positioned at the start.
+ * @param targetFd The file descriptor of the empty target.
+ *
+ * @return true if all data has been copied, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfFile::copyFileData(int sourceFd, int targetFd) {
+    #ifdef FICLONE
+        if (ioctl(targetFd, FICLONE, sourceFd) == 0) {
+            return true;
+        }
+    #endif
+
+    struct stat sourceStat;
+    if (fstat(sourceFd, &sourceStat) != 0) {
+        return false;
+    }
+    off_t remaining {sourceStat.st_size};
+    bool useCopyFileRange {true};
+    std::vector<char> buffer;
+
+    while (remaining > 0) {
+        ssize_t copied {-1};
+        if (useCopyFileRange) {
+            copied = copy_file_range(sourceFd, nullptr, targetFd, nullptr, remaining, 0);
+            // Older kernels do not copy across filesystems, nothing has been copied in that case
+            if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)
+                && remaining == sourceStat.st_size) {
+                useCopyFileRange = false;
+                continue;
+            }
+        }
+        else {
+            buffer.resize(1 << 20);
+            copied = read(sourceFd, buffer.data(), buffer.size());
+            if (copied > 0) {
+                for (ssize_t written {0}; written < copied; ) {
+                    const ssize_t result {write(targetFd, buffer.data() + written, copied - written)};
+                    if (result < 0) {
+                        if (errno == EINTR) continue;
+                        return false;
+                    }
+                    written += result;
+                }
+            }
+        }
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+        if (copied <= 0) {
+            return false;
+        }
+        remaining -= copied;
+    }
+    return true;
+}
+
+/**
+ * Returns the processed pdf as a read-only device on a memory mapping of the file.
+ * Nothing is read until the data is accessed, the mapping stays valid when the file
+ * is renamed or removed.
+ * While the file is processed, the device holds the pages written so far.
+ *
+ * @return The device, not open if the file could not be mapped or has no pages yet.
+ *
  * @throws None
  */
 std::shared_ptr<QIODevice> PdfFile::returnFileContent() {
-    std::shared_ptr<QIODevice> pdfBuffer = std::make_shared<QFile>(tempFileName.c_str());
-    if (pdfBuffer->open(QIODevice::ReadWrite)) {
-        QByteArray fileData = pdfBuffer->readAll();
-        pdfBuffer->write(fileData);
+    const std::lock_guard<std::mutex> lock(m_tempFileMutex);
+    size_t length {0};
+    std::string tail;
+    if (!m_isFinished) {
+        if (!m_isWriting || !writer->previewData(length, tail)) {
+            return std::make_shared<MappedFile>(QString());
+        }
+        return std::make_shared<MappedFile>(QString::fromStdString(tempFileName), static_cast<qint64>(length), tail);
     }
-    return std::move(pdfBuffer);
+    return std::make_shared<MappedFile>(QString::fromStdString(tempFileName));
 }
 
 /**
@@ -557,11 +1349,13 @@ std::shared_ptr<QIODevice> PdfFile::returnFileContent() {
  * @param parent the parent QObject
  * @param isRecursive a flag indicating whether to recurse through subdirectories
  * @param documentProfileIndex the index of the document profile
+ * @param isRemoteFind a flag indicating whether to list a remote directory with find on the server
  *
  * @throws None
  */
-Directory::Directory (ParseUrl Url, QObject *parent, bool isRecursive, int documentProfileIndex) : 
-    QObject (parent), m_Url(Url), p_cfMain (parent), m_isRecursive (isRecursive), m_documentProfileIndex(documentProfileIndex) {
+Directory::Directory (ParseUrl Url, QObject *parent, bool isRecursive, int documentProfileIndex, bool isRemoteFind) : 
+    QObject (parent), m_Url(Url), p_cfMain (parent), m_isRecursive (isRecursive), m_documentProfileIndex(documentProfileIndex),
+    m_isRemoteFind (isRemoteFind) {
 
 }
 
@@ -602,26 +1396,91 @@ void Directory::initialize() {
     }
     else {
         // Screen remote directory for subdirectories and pdf files and create instances of PdfFile
+        if (m_isClaiming) {
+            ClaimManager::instance().recover(m_Url);
+        }
         FtpConnection ftpConnection (m_Url);
-        std::unique_ptr<std::vector<std::string>> remoteDirPtr = ftpConnection.getRemoteDir(m_isRecursive);
+        std::unique_ptr<ListingSnapshot> snapshot;
+        if (!m_snapshotName.empty()) {
+            snapshot = std::make_unique<ListingSnapshot>(m_snapshotName, m_isRecursive);
+            snapshot->load();
+        }
+        std::unique_ptr<std::vector<FtpConnection::remoteFile>> remoteDirPtr = ftpConnection.getRemoteDir(m_isRecursive, m_isRemoteFind, snapshot.get());
         if (remoteDirPtr != nullptr) {
-            for (std::string entry: *(remoteDirPtr)) {
+            std::vector<FtpConnection::remoteFile> offeredFiles;
+            m_changedFiles = 0;
+            for (const FtpConnection::remoteFile &entry: *(remoteDirPtr)) {
+                if (entry.isDirectory) {
+                    continue;
+                }
+                // Files offered before but not processed yet are offered again, they settled already
+                if (snapshot != nullptr && snapshot->isPending(entry)) {
+                    offeredFiles.push_back(entry);
+                    continue;
+                }
+                // Files of the previous scan are skipped unless they changed
+                if (snapshot != nullptr && !snapshot->isChanged(entry)) {
+                    continue;
+                }
+                m_changedFiles++;
+                // Files still being uploaded wait until they stop changing
+                if (snapshot == nullptr || snapshot->isSettled(entry, m_settleTime)) {
+                    offeredFiles.push_back(entry);
+                }
+            }
+            if (m_isClaiming) {
+                ClaimManager::instance().claim(m_Url, offeredFiles);
+            }
+
+            for (const FtpConnection::remoteFile &entry: offeredFiles) {
                 // Construct new Url on m_Url with entry, which is the directory and filename (= FileDir)
                 std::shared_ptr<ParseUrl> ptr_newUrl = std::make_shared<ParseUrl> (m_Url);
-                ptr_newUrl->FileDir(entry);
+                ptr_newUrl->FileDir(entry.path);
                 #ifdef DEBUG
-                    std::cout << "Directory(), entry: " << entry << std::endl;
+                    std::cout << "Directory(), entry: " << entry.path << std::endl;
                     std::cout << "Directory(), found new file with Url: " << ptr_newUrl->Url() << std::endl;
                     std::cout << "Creating new instance of PdfFile with p_cfMain to " << p_cfMain << std::endl;
                     std::cout << "foundNewFile from Directory()" << std::endl;
                 #endif
                 emit foundNewFile(ptr_newUrl, m_documentProfileIndex);
             }    
+            // Offered files are only taken as seen once they are processed and gone from the server
+            if (snapshot != nullptr) {
+                snapshot->replace(*remoteDirPtr);
+                snapshot->Offered(offeredFiles);
+                snapshot->save();
+            }
         }
         
     }
 }
 
+/**
+ * Only offers files that are new or changed since the previous scan with this snapshot.
+ * Unchanged remote directories are not read again.
+ *
+ * @param profileName The name of the network profile the snapshot belongs to.
+ * @param settleTime The time a new file has to keep its size and modification time before it is offered.
+ *
+ * @throws None
+ */
+void Directory::Snapshot(const std::string &profileName, std::chrono::seconds settleTime) {
+    m_snapshotName = profileName;
+    m_settleTime = settleTime;
+}
+
+/**
+ * Claims the remote files for this instance before offering them, so instances scanning
+ * the same directory do not process a file twice. Orphaned claims are recovered first.
+ *
+ * @param isClaiming true to claim the files.
+ *
+ * @throws None
+ */
+void Directory::Claiming(bool isClaiming) {
+    m_isClaiming = isClaiming;
+}
+
 
 /*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
     Copyright (C) 2024 Simon-Friedrich Böttger email ( at ) simonboettger . de
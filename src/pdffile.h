@@ -2,36 +2,52 @@
 #define PDFFILE_H
 
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <string>
 
 // Tesseract api
 #include <tesseract/baseapi.h>
-#include <tesseract/renderer.h>
 #include <tesseract/ocrclass.h>
 #include <leptonica/allheaders.h>
 
 //Qt 6.x
 #include <QObject>
 #include <QIODevice>
-#include <QBuffer>
 
 // local
 #include "parseurl.h"
 #include "ftpconnection.h"
 #include "settings.h"
 #include "scan2ocr.h"
+#include "pagehash.h"
+#include "pdfwriter.h"
+#include "jpegdecoder.h"
 
 class PdfFile : public QObject {
     Q_OBJECT
 
 public:
     PdfFile(ParseUrl Url, QObject *parent = nullptr, int documentProfileIndex = 0);
+    ~PdfFile();
     void initialize();
+    void startDownload();
     
     // file handling
     bool removeFile();
     bool renameToFileName (const std::string fileName);
     std::string FileName() { return m_possibleFileName; };
+    std::string SourceFileName() { return m_Url.Filename(); };
+    std::string SourceUrl() { return m_Url.Url(); };
+    bool isRemote() { return m_Url.Scheme() != "file"; };
+    std::string Source() const;
+    bool isDownloaded();
+    size_t DownloadedBytes() const { return m_downloadedBytes; };
+    std::chrono::microseconds DownloadWait() const { return std::chrono::microseconds(m_downloadWait); };
+    bool isFinished() const { return m_isFinished; };
     std::shared_ptr<QIODevice> returnFileContent();
     const char *pdfFileName() { return tempFileName.c_str(); };
 
@@ -40,6 +56,8 @@ public:
 signals:
     // New status value
     void statusChange();
+    // Pages written to the output file so far, they can be previewed
+    void pagesWritten(int pageCount);
     // All processing done
     void finished();
 
@@ -60,11 +78,44 @@ private:
     ParseUrl m_Url;
     QObject m_parent;
     Settings settings;
-    FtpConnection ftpConnection {m_Url};
-    tesseract::TessBaseAPI ocr;
-    std::unique_ptr<tesseract::TessPDFRenderer>renderer;
+    // Content of a remote file, queued with the TransferManager ahead of processing
+    std::future<std::unique_ptr<std::string>> m_download;
+    std::mutex m_downloadMutex;
+    bool m_isDownloadQueued {false};
+    // Bytes received so far and the time initialize waited for the download
+    std::atomic<size_t> m_downloadedBytes {0};
+    std::atomic<int64_t> m_downloadWait {0};
+    // Pages are recognized in parallel, each worker borrows an ocr engine of its own
+    std::vector<std::unique_ptr<tesseract::TessBaseAPI>> m_ocrEngines;
+    std::vector<tesseract::TessBaseAPI *> m_idleOcrEngines;
+    std::mutex m_ocrEnginesMutex;
+    std::string m_language;
+    tesseract::TessBaseAPI *acquireOcrEngine();
+    void releaseOcrEngine(tesseract::TessBaseAPI *api);
+
+    std::unique_ptr<PdfWriter>writer;
     
-    const std::string tempFileName = settings.TmpDir() + m_Url.Filename();
+    // Staged as hidden file in the destination directory, so the final rename does not copy the data.
+    // Created when the pdf is written, removed by the destructor unless it has been renamed.
+    std::string tempFileName;
+    static constexpr int cStagingAttempts = 100;
+    static inline std::atomic<unsigned int> s_stagingCounter {0};
+    static std::string createStagingFile(std::string directory, const std::string &fileName);
+    static bool moveFile(const std::string &source, const std::string &target);
+    static bool copyToFile(int sourceFd, const std::string &target);
+    static bool copyFileData(int sourceFd, int targetFd);
+
+    // Output file held in memory, tempFileName refers to it by /proc/self/fd
+    int m_memoryFd {-1};
+    std::mutex m_tempFileMutex;
+    size_t m_memoryFileSize {0};
+    // Memory used by the output files of all PdfFile objects
+    static inline std::atomic<size_t> s_memoryFileBytes {0};
+    void openMemoryFile(size_t estimatedSize);
+    void finishMemoryFile();
+    void closeMemoryFile();
+    bool writeLinearizedFile(const std::string &target);
+    static bool reserveMemory(size_t size, size_t limit);
     const std::string *readFile (std::string *pdfFile);
     void readData (const std::string *pdfData);
     void startPDF();
@@ -73,15 +124,46 @@ private:
     void processImage (const std::string *imageStringData, int page);
     bool isEmptyPage(Pix *pix);
     void transcode (Pix *&pix);
-    void ocrPage (Pix *pix, int page);
+    // Scanner borders lie completely within this distance in millimeters of the image edges
+    static constexpr double cBorderZone = 10.0;
+    Box *findContentBox(Pix *pix);
+    static bool isScannerBorder(Pix *component, int x, int y, int width, int height, int borderZone);
+    std::string ocrPage (tesseract::TessBaseAPI *api, Pix *pix, int page, Box *contentBox = nullptr);
+    bool reuseOcrPage (const PageHash &pageHash, std::string &text);
+    std::future<std::vector<PdfWriter::image>> encodePageImages (Pix *pix, const std::string *jpegData, const JpegDecoder &jpegDecoder);
+    void addPage (Pix *pix, int page, std::future<std::vector<PdfWriter::image>> &pageImages, std::string &&text);
+
+    // Pixels of all pages and pixels handed to ocr
+    std::atomic<size_t> m_pageArea {0};
+    std::atomic<size_t> m_recognizedArea {0};
+
+    // Uncompressed and compressed size of the binary pages and the time spent compressing them
+    std::atomic<size_t> m_bilevelRawBytes {0};
+    std::atomic<size_t> m_bilevelEncodedBytes {0};
+    std::atomic<int64_t> m_bilevelEncodeTime {0};
+
+    // Hashes and text layers of the most recently recognized pages, repeated pages reuse the text layer.
+    // Repeated pages (double feeds, rescans) follow the original closely, older pages are dropped,
+    // so memory and comparisons per page stay bounded on large documents.
+    static constexpr size_t cRecognizedPages = 16;
+    struct recognizedPage {
+        PageHash hash;
+        std::string text;
+    };
+    std::deque<recognizedPage> m_recognizedPages;
+    std::mutex m_recognizedPagesMutex;
+    std::atomic<int> m_duplicatePages {0};
 
     void monitorProgress(tesseract::ETEXT_DESC *monitor, int paget);
     void ocrProcess(tesseract::TessBaseAPI *api, tesseract::ETEXT_DESC *monitor);
 
-    int myProgress {0};
+    std::atomic<int> myProgress {0};
+    std::atomic<bool> m_isFinished {false};
+    // Set once the writer exists, the preview may use it from then on
+    std::atomic<bool> m_isWriting {false};
 
     std::string m_possibleFileName {""};
-    void getFileName();
+    void getFileName(tesseract::TessBaseAPI *api);
 
     int m_documentProfileIndex;
     Settings::documentProfile documentProfile;
@@ -91,8 +173,11 @@ class Directory : public QObject {
     Q_OBJECT
 
 public:
-    Directory(ParseUrl Url, QObject *parent = nullptr, bool isRecursive = true, int documentProfileIndex = 0);
+    Directory(ParseUrl Url, QObject *parent = nullptr, bool isRecursive = true, int documentProfileIndex = 0, bool isRemoteFind = false);
     void initialize();
+    void Snapshot(const std::string &profileName, std::chrono::seconds settleTime = std::chrono::seconds(0));
+    void Claiming(bool isClaiming);
+    size_t ChangedFiles() const { return m_changedFiles; };
 
 signals:
     void foundNewFile(std::shared_ptr<ParseUrl> ptr_Url, int documentProfileIndex);
@@ -102,6 +187,15 @@ private:
     QObject *p_cfMain {nullptr};
     bool m_isRecursive {false};
     int m_documentProfileIndex;
+    bool m_isRemoteFind {false};
+    // Network profile whose listing snapshot is used, empty to offer all files
+    std::string m_snapshotName;
+    // New files are offered once they stayed the same for this time
+    std::chrono::seconds m_settleTime {0};
+    // New or changed files seen by the last scan, settled or not
+    size_t m_changedFiles {0};
+    // Claim the files before offering them, other instances scan the same directory
+    bool m_isClaiming {false};
 };
 
 #endif
@@ -0,0 +1,1190 @@
+#include "pdfwriter.h"
+
+// local
+#include "jbig2encoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <locale>
+#include <memory>
+#include <regex>
+#include <sstream>
+
+/**
+ * Constructs a PdfWriter for the given output file.
+ *
+ * @param fileName The name of the pdf file to write.
+ * @param fontFileName The glyphless TrueType font of tesseract (pdf.ttf in the tessdata directory).
+ *
+ * @throws None
+ */
+PdfWriter::PdfWriter(const std::string &fileName, const std::string &fontFileName) : m_fileName(fileName), m_fontFileName(fontFileName) {
+}
+
+/**
+ * Finishes the document if endDocument has not been called.
+ *
+ * @throws None
+ */
+PdfWriter::~PdfWriter() {
+    if (m_writerThread.joinable()) {
+        endDocument();
+    }
+}
+
+/**
+ * Opens the output file, writes the header, the catalog and the text layer font
+ * and starts the writer thread.
+ *
+ * @param title The document title stored in the document information dictionary.
+ *
+ * @return True if the file could be opened, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfWriter::beginDocument(const std::string &title) {
+    m_file.open(m_fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        std::cerr << "PdfWriter::beginDocument: cannot open " << m_fileName << std::endl;
+        return false;
+    }
+    m_title = title;
+
+    std::ifstream fontFile(m_fontFileName, std::ios::in | std::ios::binary);
+    if (fontFile.is_open()) {
+        m_font.assign(std::istreambuf_iterator<char>(fontFile), std::istreambuf_iterator<char>());
+    }
+
+    write(cFileHeader);
+
+    // Catalog and page tree have fixed object numbers, the page tree is written at the end
+    while (static_cast<int>(m_objectOffsets.size()) <= FONT) {
+        newObject();
+    }
+    writeDocumentStart();
+
+    m_writerThread = std::thread(&PdfWriter::writePages, this);
+    return m_file.good();
+}
+
+/**
+ * Hands a finished page to the writer thread. Thread safe.
+ *
+ * @param pageNumber The zero based position of the page in the source document.
+ * @param pdfPage The page with its size in points, the images in drawing order and the text layer.
+ *
+ * @throws None
+ */
+void PdfWriter::addPage(int pageNumber, page &&pdfPage) {
+    {
+        const std::lock_guard<std::mutex> lock(m_pagesMutex);
+        m_pendingPages[pageNumber] = std::move(pdfPage);
+    }
+    m_pagesChanged.notify_one();
+}
+
+/**
+ * Tells the writer thread that a page of the source document is left out (e.g. an empty page). Thread safe.
+ *
+ * @param pageNumber The zero based position of the page in the source document.
+ *
+ * @throws None
+ */
+void PdfWriter::skipPage(int pageNumber) {
+    {
+        const std::lock_guard<std::mutex> lock(m_pagesMutex);
+        m_pendingPages[pageNumber] = std::nullopt;
+    }
+    m_pagesChanged.notify_one();
+}
+
+/**
+ * Writer thread: appends the pending pages as soon as all their predecessors are written.
+ * Pages still missing when the document ends are left out, the remaining ones are written in order.
+ *
+ * @throws None
+ */
+void PdfWriter::writePages() {
+    std::unique_lock<std::mutex> lock(m_pagesMutex);
+    while (true) {
+        m_pagesChanged.wait(lock, [this] { return m_isEnding || m_pendingPages.count(m_nextPage) > 0; });
+
+        // At the end gaps are ignored and the remaining pages follow in order
+        auto next = m_isEnding ? m_pendingPages.begin() : m_pendingPages.find(m_nextPage);
+        if (next == m_pendingPages.end()) {
+            break;
+        }
+
+        std::optional<page> pdfPage {std::move(next->second)};
+        m_nextPage = next->first + 1;
+        m_pendingPages.erase(next);
+
+        // Pages are written without holding the lock, so workers can hand in the next pages meanwhile
+        lock.unlock();
+        if (pdfPage.has_value()) {
+            writePage(*pdfPage);
+            if (m_pageWritten) {
+                updatePreview();
+                m_pageWritten(static_cast<int>(m_pageObjects.size()));
+            }
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Appends a page: the page object, its images, the content stream drawing them and the
+ * invisible text layer. All objects of a page follow each other, starting with the page object.
+ * Only called by the writer thread.
+ *
+ * @param pdfPage The page with its size in points, the images in drawing order and the text layer.
+ *
+ * @return True if the page has been written, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfWriter::writePage(const page &pdfPage) {
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    const int pageObject {newObject()};
+    const int contentObject {newObject()};
+    std::vector<int> imageObjects;
+    for (size_t i = 0; i < pdfPage.images.size(); i++) {
+        imageObjects.push_back(newObject());
+    }
+
+    std::string content;
+    std::string xObjects;
+    std::vector<std::string> dictionaries;
+    for (size_t i = 0; i < pdfPage.images.size(); i++) {
+        const image &pdfImage = pdfPage.images[i];
+        std::string dictionary {"/Type /XObject /Subtype /Image"};
+        dictionary += " /Width " + std::to_string(pdfImage.width) + " /Height " + std::to_string(pdfImage.height);
+        if (pdfImage.isMask) {
+            dictionary += " /ImageMask true /BitsPerComponent 1";
+        }
+        else {
+            dictionary += " /ColorSpace " + pdfImage.colorSpace + " /BitsPerComponent " + std::to_string(pdfImage.bitsPerComponent);
+        }
+        dictionary += " /Filter " + pdfImage.filter;
+        if (!pdfImage.decodeParms.empty()) {
+            dictionary += " /DecodeParms " + pdfImage.decodeParms;
+        }
+        if (!pdfImage.decode.empty()) {
+            dictionary += " /Decode " + pdfImage.decode;
+        }
+        if (pdfImage.mask >= 0 && pdfImage.mask < static_cast<int>(imageObjects.size())) {
+            dictionary += " /Mask " + std::to_string(imageObjects[pdfImage.mask]) + " 0 R";
+        }
+        dictionaries.push_back(std::move(dictionary));
+
+        const std::string name {"/Im" + std::to_string(i)};
+        xObjects += " " + name + " " + std::to_string(imageObjects[i]) + " 0 R";
+
+        // Every image is scaled to the whole page
+        if (!pdfImage.isMask) {
+            content += "q " + number(pdfPage.width) + " 0 0 " + number(pdfPage.height) + " 0 0 cm " + name + " Do Q\n";
+        }
+    }
+    content += pdfPage.text;
+
+    // File order of the objects, the linearized copy keeps it
+    pageSection section;
+    section.objects.push_back(pageObject);
+    section.objects.insert(section.objects.end(), imageObjects.begin(), imageObjects.end());
+    section.objects.push_back(contentObject);
+    section.content = contentObject;
+
+    writeObject(pageObject, "<< /Type /Page /Parent " + std::to_string(PAGES) + " 0 R"
+        + " /MediaBox [0 0 " + number(pdfPage.width) + " " + number(pdfPage.height) + "]"
+        + " /Contents " + std::to_string(contentObject) + " 0 R"
+        + " /Resources << /XObject <<" + xObjects + " >> /Font << /f-0-0 " + std::to_string(FONT) + " 0 R >> >> >>");
+    for (size_t i = 0; i < pdfPage.images.size(); i++) {
+        writeStream(imageObjects[i], dictionaries[i], pdfPage.images[i].data);
+    }
+    writeStream(contentObject, "", content);
+
+    m_pageObjects.push_back(pageObject);
+    m_pageSections.push_back(section);
+    return m_file.good();
+}
+
+/**
+ * Waits for the writer thread to append all pending pages, then writes the page tree,
+ * the document information, the cross reference table and closes the file.
+ * The file is a complete document in page order, writeLinearized creates the linearized copy.
+ *
+ * @return True if the document has been written completely, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfWriter::endDocument() {
+    if (m_writerThread.joinable()) {
+        {
+            const std::lock_guard<std::mutex> lock(m_pagesMutex);
+            m_isEnding = true;
+        }
+        m_pagesChanged.notify_one();
+        m_writerThread.join();
+    }
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    writeObject(PAGES, pageTree());
+
+    m_infoObject = newObject();
+    writeObject(m_infoObject, "<< /Producer (scan2ocr) /Title <" + hexString(std::u16string(1, u'\xFEFF') + toUtf16(m_title.c_str())) + "> >>");
+
+    write(crossReference(m_offset, m_infoObject));
+
+    const bool isGood {m_file.good()};
+    m_file.close();
+    return isGood;
+}
+
+/**
+ * Prepares a linearized (fast web view) copy, has to be called before beginDocument.
+ * The document itself is still written in page order, so the pages written so far can be
+ * previewed and no written byte changes. The dictionaries and stream positions of all
+ * objects are kept for writeLinearized.
+ *
+ * @param isLinearized True for the linearized layout.
+ *
+ * @throws None
+ */
+void PdfWriter::setLinearized(bool isLinearized) {
+    m_isLinearized = isLinearized;
+}
+
+/**
+ * Sets the function the writer thread calls after every written page.
+ * Enables the preview data, has to be called before beginDocument.
+ *
+ * @param callback Called with the number of pages written so far.
+ *
+ * @throws None
+ */
+void PdfWriter::setPageWrittenCallback(std::function<void(int)> callback) {
+    m_pageWritten = std::move(callback);
+}
+
+/**
+ * Provides the pages written so far as complete document: the first length bytes of
+ * the file followed by the tail. The file is not changed before the length. Thread safe.
+ *
+ * @param length Receives the length of the file data to use.
+ * @param tail Receives the page tree, cross reference table and trailer.
+ *
+ * @return False if no page has been written yet.
+ *
+ * @throws None
+ */
+bool PdfWriter::previewData(size_t &length, std::string &tail) {
+    const std::lock_guard<std::mutex> lock(m_pagesMutex);
+    if (m_previewLength == 0) {
+        return false;
+    }
+    length = m_previewLength;
+    tail = m_previewTail;
+    return true;
+}
+
+/**
+ * Creates the end of a document holding the pages written so far. Only called by the writer thread.
+ *
+ * @throws None
+ */
+void PdfWriter::updatePreview() {
+    // Readers of the preview open the file themselves
+    m_file.flush();
+
+    // The page tree is placed behind the last page until endDocument writes it there
+    m_objectOffsets[PAGES] = m_offset;
+    std::string tail {std::to_string(PAGES) + " 0 obj\n" + pageTree() + "\nendobj\n"};
+    tail += crossReference(m_offset + tail.size(), 0);
+
+    const std::lock_guard<std::mutex> lock(m_pagesMutex);
+    m_previewLength = m_offset;
+    m_previewTail = std::move(tail);
+}
+
+/**
+ * Creates the page tree of the written pages.
+ *
+ * @return The page tree dictionary.
+ *
+ * @throws None
+ */
+std::string PdfWriter::pageTree() const {
+    std::string kids;
+    for (const int pageObject : m_pageObjects) {
+        kids += std::to_string(pageObject) + " 0 R ";
+    }
+    return "<< /Type /Pages /Kids [ " + kids + "] /Count " + std::to_string(m_pageObjects.size()) + " >>";
+}
+
+/**
+ * Creates the cross reference table of all objects and the trailer.
+ *
+ * @param xrefOffset The file offset the table is written at.
+ * @param infoObject The document information dictionary, 0 for none.
+ *
+ * @return The cross reference table, trailer and end of file marker.
+ *
+ * @throws None
+ */
+std::string PdfWriter::crossReference(size_t xrefOffset, int infoObject) const {
+    std::string xref {"xref\n0 " + std::to_string(m_objectOffsets.size()) + "\n" + xrefEntries(0, m_objectOffsets.size())};
+    xref += "trailer\n<< /Size " + std::to_string(m_objectOffsets.size()) + " /Root " + std::to_string(CATALOG) + " 0 R";
+    if (infoObject > 0) {
+        xref += " /Info " + std::to_string(infoObject) + " 0 R";
+    }
+    xref += " >>\nstartxref\n" + std::to_string(xrefOffset) + "\n%%EOF\n";
+    return xref;
+}
+
+/**
+ * Creates the entries of a cross reference table.
+ *
+ * @param first The first object number.
+ * @param end The object number behind the last entry.
+ *
+ * @return The entries, 20 bytes each.
+ *
+ * @throws None
+ */
+std::string PdfWriter::xrefEntries(size_t first, size_t end) const {
+    std::string entries;
+    char entry[21];
+    for (size_t i = first; i < end; i++) {
+        if (i == 0) {
+            entries += "0000000000 65535 f \n";
+        }
+        else {
+            std::snprintf(entry, sizeof(entry), "%010zu 00000 n \n", m_objectOffsets[i]);
+            entries += entry;
+        }
+    }
+    return entries;
+}
+
+/**
+ * Writes the catalog and the text layer font.
+ *
+ * @throws None
+ */
+void PdfWriter::writeDocumentStart() {
+    writeObject(CATALOG, "<< /Type /Catalog /Pages " + std::to_string(PAGES) + " 0 R >>");
+    writeFont();
+}
+
+/**
+ * Writes a linearized copy of the finished document in the layout of Annex F of ISO 32000:
+ * linearization dictionary, first page cross reference table, catalog and page tree,
+ * the first page section (the first page and the font shared by all pages), the primary
+ * hint stream, the remaining pages, the document information and the main cross reference
+ * table. The objects behind the first page section get the low object numbers, so the
+ * main cross reference table starts at object 0 and the first page table covers the rest.
+ * The document written by endDocument is only read, a preview mapping it is not affected.
+ *
+ * Every value at the start of the file depends on what follows it, so the copy is laid out
+ * three times: the first pass measures the objects for the hint tables, the second places
+ * the hint stream and the third writes the file with the values of the second.
+ * Documents without pages are not linearized.
+ *
+ * @param sourceFileName The document written by endDocument, it may have been moved since.
+ * @param fileName The file the copy is written to.
+ *
+ * @return True if the copy has been written, false otherwise.
+ *
+ * @throws None
+ */
+bool PdfWriter::writeLinearized(const std::string &sourceFileName, const std::string &fileName) {
+    if (!m_isLinearized || m_pageSections.empty() || m_infoObject == 0 || m_file.is_open()) {
+        return false;
+    }
+    std::ifstream source(sourceFileName, std::ios::in | std::ios::binary);
+    if (!source.is_open()) {
+        std::cerr << "PdfWriter::writeLinearized: cannot open " << sourceFileName << std::endl;
+        return false;
+    }
+
+    // Object numbers of the copy, index 0 is the free head of the xref table:
+    // the pages behind the first one and the document information form the main section
+    std::vector<int> sourceObjects {0};
+    std::vector<linearizedPage> pages(m_pageSections.size());
+    auto addPageObjects = [&](size_t page) {
+        pages[page].first = static_cast<int>(sourceObjects.size());
+        for (const int object : m_pageSections[page].objects) {
+            if (object == m_pageSections[page].content) {
+                pages[page].content = static_cast<int>(sourceObjects.size());
+            }
+            sourceObjects.push_back(object);
+        }
+        pages[page].objects = static_cast<int>(sourceObjects.size()) - pages[page].first;
+    };
+    for (size_t page = 1; page < m_pageSections.size(); page++) {
+        addPageObjects(page);
+    }
+    sourceObjects.push_back(m_infoObject);
+    const int mainObjects {static_cast<int>(sourceObjects.size())};
+
+    // The first page section follows, the shared font belongs to the first page
+    const int linearizationObject {mainObjects};
+    sourceObjects.push_back(0);
+    sourceObjects.push_back(CATALOG);
+    sourceObjects.push_back(PAGES);
+    addPageObjects(0);
+    std::vector<int> sharedObjects;
+    for (const int object : m_fontObjects) {
+        sharedObjects.push_back(static_cast<int>(sourceObjects.size()));
+        sourceObjects.push_back(object);
+    }
+    pages[0].objects = static_cast<int>(sourceObjects.size()) - pages[0].first;
+    const int hintObject {static_cast<int>(sourceObjects.size())};
+    sourceObjects.push_back(0);
+    const int size {static_cast<int>(sourceObjects.size())};
+
+    std::vector<int> numbers(m_objects.size(), 0);
+    for (int object = 1; object < size; object++) {
+        if (sourceObjects[object] > 0) {
+            numbers[sourceObjects[object]] = object;
+        }
+    }
+
+    // Values found by the previous pass
+    size_t fileLength {0}, hintOffset {0}, hintLength {0}, firstPageEnd {0}, mainXrefOffset {0}, mainXrefEntries {0};
+    m_isCopying = true;
+    m_objectOffsets.assign(size, 0);
+    m_objectEnds.assign(size, 0);
+
+    for (int pass = 0; pass < 3; pass++) {
+        std::ifstream *data {nullptr};
+        if (pass == 2) {
+            m_file.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!m_file.is_open()) {
+                std::cerr << "PdfWriter::writeLinearized: cannot open " << fileName << std::endl;
+                break;
+            }
+            data = &source;
+        }
+        // The hint tables use the object positions of the previous pass
+        size_t sharedOffset {0};
+        const std::string hints {hintStream(pages, sharedObjects, sharedOffset)};
+        m_offset = 0;
+
+        write(cFileHeader);
+        writeObject(linearizationObject, linearizationDictionary(fileLength, hintOffset, hintLength, pages[0].first, firstPageEnd,
+                                                                 pages.size(), mainXrefEntries));
+        const size_t firstXrefOffset {m_offset};
+        write("xref\n" + std::to_string(linearizationObject) + " " + std::to_string(size - linearizationObject) + "\n"
+              + xrefEntries(linearizationObject, size));
+        write(firstPageTrailer(size, mainXrefOffset, numbers[CATALOG], numbers[m_infoObject]));
+
+        for (int object = linearizationObject + 1; object < hintObject; object++) {
+            copyObject(data, object, sourceObjects[object], numbers);
+        }
+        firstPageEnd = m_offset;
+
+        hintOffset = m_offset;
+        writeStream(hintObject, "/S " + std::to_string(sharedOffset), hints);
+        hintLength = m_offset - hintOffset;
+
+        for (int object = 1; object < mainObjects; object++) {
+            copyObject(data, object, sourceObjects[object], numbers);
+        }
+
+        mainXrefOffset = m_offset;
+        const std::string subsection {"xref\n0 " + std::to_string(mainObjects)};
+        // Offset of the end of line before the first entry
+        mainXrefEntries = m_offset + subsection.size();
+        write(subsection + "\n" + xrefEntries(0, mainObjects));
+        write("trailer\n<< /Size " + std::to_string(mainObjects) + " >>\nstartxref\n" + std::to_string(firstXrefOffset) + "\n%%EOF\n");
+        fileLength = m_offset;
+    }
+    m_isCopying = false;
+
+    if (!m_file.is_open()) {
+        return false;
+    }
+    const bool isGood {m_file.good() && !source.fail()};
+    m_file.close();
+    return isGood;
+}
+
+/**
+ * Writes an object of the document written by endDocument to the linearized copy.
+ *
+ * @param source The document written by endDocument, nullptr while measuring the layout.
+ * @param object The object number in the copy.
+ * @param sourceObject The object number in the source document.
+ * @param numbers The object numbers of the copy indexed by the source object numbers.
+ *
+ * @throws None
+ */
+void PdfWriter::copyObject(std::ifstream *source, int object, int sourceObject, const std::vector<int> &numbers) {
+    const objectData &data {m_objects[sourceObject]};
+    const std::string dictionary {renumber(data.dictionary, numbers)};
+    if (!data.isStream) {
+        writeObject(object, dictionary);
+    }
+    else {
+        m_objectOffsets[object] = m_offset;
+        write(streamHeader(object, dictionary, data.dataLength));
+        if (source != nullptr) {
+            std::string streamData(data.dataLength, '\0');
+            source->seekg(data.dataOffset);
+            source->read(streamData.data(), streamData.size());
+            write(streamData);
+        }
+        else {
+            m_offset += data.dataLength;
+        }
+        write("\nendstream\nendobj\n");
+    }
+    m_objectEnds[object] = m_offset;
+}
+
+/**
+ * Replaces the object numbers of all references in a dictionary.
+ *
+ * @param dictionary The dictionary written by this class.
+ * @param numbers The new object numbers indexed by the old ones.
+ *
+ * @return The dictionary with the new object numbers.
+ *
+ * @throws None
+ */
+std::string PdfWriter::renumber(const std::string &dictionary, const std::vector<int> &numbers) {
+    static const std::regex reference("(\\d+) 0 R\\b");
+    std::string result;
+    size_t last {0};
+    for (std::sregex_iterator next(dictionary.begin(), dictionary.end(), reference), end; next != end; next++) {
+        const size_t object {std::stoul((*next)[1].str())};
+        result += dictionary.substr(last, next->position() - last);
+        result += std::to_string((object < numbers.size()) ? numbers[object] : 0) + " 0 R";
+        last = next->position() + next->length();
+    }
+    return result + dictionary.substr(last);
+}
+
+/**
+ * Creates the primary hint stream of the linearized copy: the page offset hint table and the
+ * shared object hint table. The only shared objects are the font objects of the first page section,
+ * the shared object table has an entry for every object of the first page section.
+ * As required, the offsets and lengths disregard the hint stream itself.
+ *
+ * @param pages The object ranges of the pages.
+ * @param sharedObjects The object numbers of the font objects, all pages use them.
+ * @param sharedOffset Receives the offset of the shared object hint table in the stream.
+ *
+ * @return The stream data.
+ *
+ * @throws None
+ */
+std::string PdfWriter::hintStream(const std::vector<linearizedPage> &pages, const std::vector<int> &sharedObjects, size_t &sharedOffset) const {
+    std::string data;
+    uint64_t bitBuffer {0};
+    int bitCount {0};
+    auto put = [&](uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; i--) {
+            bitBuffer = (bitBuffer << 1) | ((value >> i) & 1);
+            if (++bitCount == 8) {
+                data += static_cast<char>(bitBuffer & 0xFF);
+                bitCount = 0;
+            }
+        }
+    };
+    // Every item of the per page entries starts at a byte boundary
+    auto flush = [&]() {
+        if (bitCount > 0) {
+            put(0, 8 - bitCount);
+        }
+    };
+    auto bitsFor = [](size_t value) {
+        int bits {0};
+        while (value >> bits) {
+            bits++;
+        }
+        return bits;
+    };
+    // The objects of a page have consecutive numbers and follow each other in the file
+    auto length = [this](int first, int objects) {
+        return m_objectEnds[first + objects - 1] - m_objectOffsets[first];
+    };
+    auto sharedCount = [&](size_t page) {
+        return (page == 0) ? size_t {0} : sharedObjects.size();
+    };
+
+    size_t minObjects {SIZE_MAX}, maxObjects {0}, minLength {SIZE_MAX}, maxLength {0};
+    size_t minContentOffset {SIZE_MAX}, maxContentOffset {0}, minContentLength {SIZE_MAX}, maxContentLength {0};
+    for (const linearizedPage &page : pages) {
+        const size_t objects {static_cast<size_t>(page.objects)};
+        const size_t pageLength {length(page.first, page.objects)};
+        const size_t contentOffset {m_objectOffsets[page.content] - m_objectOffsets[page.first]};
+        const size_t contentLength {length(page.content, 1)};
+        minObjects = std::min(minObjects, objects);
+        maxObjects = std::max(maxObjects, objects);
+        minLength = std::min(minLength, pageLength);
+        maxLength = std::max(maxLength, pageLength);
+        minContentOffset = std::min(minContentOffset, contentOffset);
+        maxContentOffset = std::max(maxContentOffset, contentOffset);
+        minContentLength = std::min(minContentLength, contentLength);
+        maxContentLength = std::max(maxContentLength, contentLength);
+    }
+    const int objectBits {bitsFor(maxObjects - minObjects)};
+    const int lengthBits {bitsFor(maxLength - minLength)};
+    const int contentOffsetBits {bitsFor(maxContentOffset - minContentOffset)};
+    const int contentLengthBits {bitsFor(maxContentLength - minContentLength)};
+    // Shared objects are identified by their position in the shared object hint table
+    const int sharedCountBits {bitsFor((pages.size() > 1) ? sharedObjects.size() : 0)};
+    const int identifierBits {bitsFor(sharedObjects.empty() ? 0 : sharedObjects.back() - pages[0].first)};
+
+    // Page offset hint table header, the first page precedes the hint stream
+    put(minObjects, 32);
+    put(m_objectOffsets[pages[0].first], 32);
+    put(objectBits, 16);
+    put(minLength, 32);
+    put(lengthBits, 16);
+    put(minContentOffset, 32);
+    put(contentOffsetBits, 16);
+    put(minContentLength, 32);
+    put(contentLengthBits, 16);
+    put(sharedCountBits, 16);
+    put(identifierBits, 16);
+    // No fractional positions of the shared objects
+    put(0, 16);
+    put(1, 16);
+
+    for (const linearizedPage &page : pages) {
+        put(page.objects - minObjects, objectBits);
+    }
+    flush();
+    for (const linearizedPage &page : pages) {
+        put(length(page.first, page.objects) - minLength, lengthBits);
+    }
+    flush();
+    for (size_t page = 0; page < pages.size(); page++) {
+        put(sharedCount(page), sharedCountBits);
+    }
+    flush();
+    for (size_t page = 0; page < pages.size(); page++) {
+        for (size_t i = 0; i < sharedCount(page); i++) {
+            put(sharedObjects[i] - pages[0].first, identifierBits);
+        }
+    }
+    flush();
+    for (const linearizedPage &page : pages) {
+        put(m_objectOffsets[page.content] - m_objectOffsets[page.first] - minContentOffset, contentOffsetBits);
+    }
+    flush();
+    for (const linearizedPage &page : pages) {
+        put(length(page.content, 1) - minContentLength, contentLengthBits);
+    }
+    flush();
+
+    // Shared object hint table: one group per object of the first page section, there is no shared objects section
+    sharedOffset = data.size();
+    const linearizedPage &firstPage {pages.front()};
+    size_t minGroupLength {SIZE_MAX}, maxGroupLength {0};
+    for (int object = firstPage.first; object < firstPage.first + firstPage.objects; object++) {
+        minGroupLength = std::min(minGroupLength, length(object, 1));
+        maxGroupLength = std::max(maxGroupLength, length(object, 1));
+    }
+    const int groupLengthBits {bitsFor(maxGroupLength - minGroupLength)};
+    put(0, 32);
+    put(0, 32);
+    put(firstPage.objects, 32);
+    put(firstPage.objects, 32);
+    put(0, 16);
+    put(minGroupLength, 32);
+    put(groupLengthBits, 16);
+    for (int object = firstPage.first; object < firstPage.first + firstPage.objects; object++) {
+        put(length(object, 1) - minGroupLength, groupLengthBits);
+    }
+    flush();
+    // No MD5 signatures, every group is a single object
+    for (int object = 0; object < firstPage.objects; object++) {
+        put(0, 1);
+    }
+    flush();
+    return data;
+}
+
+/**
+ * Creates the linearization parameter dictionary with fixed width values.
+ *
+ * @param fileLength The length of the file.
+ * @param hintOffset The offset of the primary hint stream.
+ * @param hintLength The length of the primary hint stream.
+ * @param firstPageObject The page object of the first page.
+ * @param firstPageEnd The offset of the end of the first page section.
+ * @param pageCount The number of pages.
+ * @param mainXrefEntries The offset of the end of line before the first entry of the main cross reference table.
+ *
+ * @return The dictionary.
+ *
+ * @throws None
+ */
+std::string PdfWriter::linearizationDictionary(size_t fileLength, size_t hintOffset, size_t hintLength, int firstPageObject,
+                                               size_t firstPageEnd, size_t pageCount, size_t mainXrefEntries) {
+    char dictionary[160];
+    std::snprintf(dictionary, sizeof(dictionary), "<< /Linearized 1 /L %10zu /H [ %10zu %10zu ] /O %10d /E %10zu /N %10zu /T %10zu >>",
+                  fileLength, hintOffset, hintLength, firstPageObject, firstPageEnd, pageCount, mainXrefEntries);
+    return dictionary;
+}
+
+/**
+ * Creates the trailer of the first page cross reference table with fixed width values.
+ *
+ * @param size The number of objects of the document.
+ * @param mainXrefOffset The offset of the main cross reference table.
+ * @param rootObject The catalog.
+ * @param infoObject The document information dictionary.
+ *
+ * @return The trailer.
+ *
+ * @throws None
+ */
+std::string PdfWriter::firstPageTrailer(size_t size, size_t mainXrefOffset, int rootObject, int infoObject) {
+    char trailer[160];
+    std::snprintf(trailer, sizeof(trailer), "trailer\n<< /Size %10zu /Prev %10zu /Root %10d 0 R /Info %10d 0 R >>\nstartxref\n0\n%%%%EOF\n",
+                  size, mainXrefOffset, rootObject, infoObject);
+    return trailer;
+}
+
+/**
+ * Encodes a Pix object as a pdf image stream with leptonica's compressed image data.
+ *
+ * @param pix The image, 1 bpp for L_G4_ENCODE, 8 or 32 bpp for L_JPEG_ENCODE.
+ * @param type The leptonica encoding, L_G4_ENCODE or L_JPEG_ENCODE.
+ * @param quality The jpeg quality, 0 for leptonica's default.
+ *
+ * @return The image, with empty data if the encoding failed.
+ *
+ * @throws None
+ */
+PdfWriter::image PdfWriter::encodeImage(Pix *pix, int type, int quality) {
+    image pdfImage;
+    L_COMP_DATA *cid {nullptr};
+    if (pix == nullptr || pixGenerateCIData(pix, type, quality, 0, &cid) != 0 || cid == nullptr) {
+        return pdfImage;
+    }
+
+    pdfImage.data.assign(reinterpret_cast<const char *>(cid->datacomp), cid->nbytescomp);
+    pdfImage.width = cid->w;
+    pdfImage.height = cid->h;
+    pdfImage.bitsPerComponent = cid->bps;
+
+    if (type == L_G4_ENCODE) {
+        // Without /BlackIs1 black pixels decode to 0, which is black in DeviceGray
+        // and the painted part of an image mask
+        pdfImage.filter = "/CCITTFaxDecode";
+        pdfImage.decodeParms = "<< /K -1 /Columns " + std::to_string(cid->w) + " /Rows " + std::to_string(cid->h) + " >>";
+        pdfImage.colorSpace = "/DeviceGray";
+    }
+    else {
+        pdfImage.filter = "/DCTDecode";
+        pdfImage.colorSpace = (cid->spp == 1) ? "/DeviceGray" : "/DeviceRGB";
+    }
+
+    l_CIDataDestroy(&cid);
+    return pdfImage;
+}
+
+/**
+ * Wraps already compressed JPEG data as a pdf image stream without decoding it.
+ *
+ * @param jpegData The JPEG file data, 8 bit gray or RGB.
+ * @param width The width of the image in pixels.
+ * @param height The height of the image in pixels.
+ * @param components The number of colour components, 1 or 3.
+ *
+ * @return The image.
+ *
+ * @throws None
+ */
+PdfWriter::image PdfWriter::jpegImage(const std::string &jpegData, int width, int height, int components) {
+    image pdfImage;
+    pdfImage.data = jpegData;
+    pdfImage.width = width;
+    pdfImage.height = height;
+    pdfImage.bitsPerComponent = 8;
+    pdfImage.filter = "/DCTDecode";
+    pdfImage.colorSpace = (components == 1) ? "/DeviceGray" : "/DeviceRGB";
+    return pdfImage;
+}
+
+/**
+ * Encodes a binary image losslessly as JBIG2 generic region.
+ * Like G4 without /BlackIs1 the filter delivers black pixels as 0, so the image
+ * can be drawn in DeviceGray as well as used as image mask.
+ *
+ * @param pix The 1 bpp image.
+ *
+ * @return The image, empty data if the image is not binary.
+ *
+ * @throws None
+ */
+PdfWriter::image PdfWriter::jbig2Image(Pix *pix) {
+    image pdfImage;
+    pdfImage.data = Jbig2Encoder::encode(pix);
+    if (pdfImage.data.empty()) {
+        return pdfImage;
+    }
+    pdfImage.width = pixGetWidth(pix);
+    pdfImage.height = pixGetHeight(pix);
+    pdfImage.bitsPerComponent = 1;
+    pdfImage.filter = "/JBIG2Decode";
+    pdfImage.colorSpace = "/DeviceGray";
+    return pdfImage;
+}
+
+/**
+ * Creates the invisible text layer of a page from the recognition result.
+ * Every word is placed at its bounding box and stretched horizontally to the width of the word,
+ * as TessPDFRenderer does with its glyphless font.
+ *
+ * @param api The ocr engine holding the recognition result of the page.
+ * @param imageHeight The height of the recognized image in pixels.
+ * @param resolution The resolution of the recognized image in ppi.
+ *
+ * @return The content stream operators of the text layer.
+ *
+ * @throws None
+ */
+std::string PdfWriter::textLayer(tesseract::TessBaseAPI *api, int imageHeight, int resolution) {
+    std::unique_ptr<tesseract::ResultIterator> iterator(api->GetIterator());
+    if (iterator == nullptr || resolution <= 0) {
+        return "";
+    }
+
+    // Every glyph of the font is 500 units wide
+    constexpr double cCharWidth = 0.5;
+    const double scale {72.0 / resolution};
+    int lineTop {0}, lineBottom {0};
+
+    std::string text {"BT\n3 Tr\n"};
+    iterator->Begin();
+    do {
+        if (iterator->Empty(tesseract::RIL_WORD)) {
+            continue;
+        }
+        if (iterator->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+            int lineLeft, lineRight;
+            iterator->BoundingBox(tesseract::RIL_TEXTLINE, &lineLeft, &lineTop, &lineRight, &lineBottom);
+        }
+
+        int left, top, right, bottom;
+        iterator->BoundingBox(tesseract::RIL_WORD, &left, &top, &right, &bottom);
+        const std::unique_ptr<const char[]> word(iterator->GetUTF8Text(tesseract::RIL_WORD));
+        if (word == nullptr) {
+            continue;
+        }
+
+        std::u16string utf16 {toUtf16(word.get())};
+        if (utf16.empty()) {
+            continue;
+        }
+        // Separate words for text extraction
+        if (!iterator->IsAtFinalElement(tesseract::RIL_TEXTLINE, tesseract::RIL_WORD)) {
+            utf16 += u' ';
+        }
+
+        const double fontSize {std::max(1.0, (lineBottom - lineTop) * scale)};
+        const double wordWidth {std::max(1, right - left) * scale};
+        const double horizontalScale {100.0 * wordWidth / (fontSize * cCharWidth * utf16.size())};
+
+        text += "/f-0-0 " + number(fontSize) + " Tf\n";
+        text += "1 0 0 1 " + number(left * scale) + " " + number((imageHeight - bottom) * scale) + " Tm\n";
+        text += number(horizontalScale) + " Tz\n";
+        text += "[<" + hexString(utf16) + ">] TJ\n";
+    } while (iterator->Next(tesseract::RIL_WORD));
+    text += "ET\n";
+
+    return text;
+}
+
+/**
+ * Reserves the next object number.
+ *
+ * @return The new object number.
+ *
+ * @throws None
+ */
+int PdfWriter::newObject() {
+    m_objectOffsets.push_back(0);
+    return static_cast<int>(m_objectOffsets.size()) - 1;
+}
+
+/**
+ * Writes data to the file and keeps track of the file offset.
+ *
+ * @param data The bytes to write.
+ *
+ * @throws None
+ */
+void PdfWriter::write(const std::string &data) {
+    // Not open while measuring the layout of the linearized copy
+    if (m_file.is_open()) {
+        m_file.write(data.data(), data.size());
+    }
+    m_offset += data.size();
+}
+
+/**
+ * Writes an indirect object.
+ *
+ * @param object The object number.
+ * @param content The object without the obj and endobj keywords.
+ *
+ * @throws None
+ */
+void PdfWriter::writeObject(int object, const std::string &content) {
+    m_objectOffsets[object] = m_offset;
+    write(std::to_string(object) + " 0 obj\n" + content + "\nendobj\n");
+    if (m_isLinearized && !m_isCopying) {
+        keepObject(object, {content, 0, 0, false});
+    }
+}
+
+/**
+ * Writes a stream object.
+ *
+ * @param object The object number.
+ * @param dictionary The entries of the stream dictionary without /Length.
+ * @param data The stream data.
+ *
+ * @throws None
+ */
+void PdfWriter::writeStream(int object, const std::string &dictionary, const std::string &data) {
+    m_objectOffsets[object] = m_offset;
+    write(streamHeader(object, dictionary, data.size()));
+    if (m_isLinearized && !m_isCopying) {
+        keepObject(object, {dictionary, m_offset, data.size(), true});
+    }
+    write(data);
+    write("\nendstream\nendobj\n");
+}
+
+/**
+ * Creates the start of a stream object up to the stream keyword.
+ *
+ * @param object The object number.
+ * @param dictionary The entries of the stream dictionary without /Length.
+ * @param length The length of the stream data.
+ *
+ * @return The object number, the stream dictionary and the stream keyword.
+ *
+ * @throws None
+ */
+std::string PdfWriter::streamHeader(int object, const std::string &dictionary, size_t length) {
+    return std::to_string(object) + " 0 obj\n<< " + dictionary + (dictionary.empty() ? "" : " ")
+        + "/Length " + std::to_string(length) + " >>\nstream\n";
+}
+
+/**
+ * Keeps the dictionary and the position of the stream data of an object for the linearized copy.
+ *
+ * @param object The object number.
+ * @param data The dictionary and the position of the stream data in the file.
+ *
+ * @throws None
+ */
+void PdfWriter::keepObject(int object, objectData &&data) {
+    if (m_objects.size() <= static_cast<size_t>(object)) {
+        m_objects.resize(object + 1);
+    }
+    m_objects[object] = std::move(data);
+}
+
+/**
+ * Writes the glyphless Type0 font of the text layer: every character code is its own
+ * unicode value (ToUnicode) and maps to the single invisible glyph of the font.
+ *
+ * @throws None
+ */
+void PdfWriter::writeFont() {
+    const int cidFont {newObject()};
+    const int cidToGidMap {newObject()};
+    const int toUnicode {newObject()};
+    const int fontDescriptor {newObject()};
+    // File order of the font objects
+    m_fontObjects = {FONT, cidFont, cidToGidMap, toUnicode, fontDescriptor};
+
+    writeObject(FONT, "<< /Type /Font /Subtype /Type0 /BaseFont /GlyphLessFont /Encoding /Identity-H"
+        " /DescendantFonts [ " + std::to_string(cidFont) + " 0 R ] /ToUnicode " + std::to_string(toUnicode) + " 0 R >>");
+
+    writeObject(cidFont, "<< /Type /Font /Subtype /CIDFontType2 /BaseFont /GlyphLessFont"
+        " /CIDSystemInfo << /Registry (Adobe) /Ordering (Identity) /Supplement 0 >>"
+        " /CIDToGIDMap " + std::to_string(cidToGidMap) + " 0 R"
+        " /FontDescriptor " + std::to_string(fontDescriptor) + " 0 R /DW 500 >>");
+
+    // All 65536 character codes map to glyph 1
+    std::string map;
+    map.reserve(2 * 65536);
+    for (int i = 0; i < 65536; i++) {
+        map += '\0';
+        map += '\1';
+    }
+    size_t compressedSize {0};
+    l_uint8 *compressed {zlibCompress(reinterpret_cast<const l_uint8 *>(map.data()), map.size(), &compressedSize)};
+    if (compressed != nullptr) {
+        writeStream(cidToGidMap, "/Filter /FlateDecode", std::string(reinterpret_cast<const char *>(compressed), compressedSize));
+        lept_free(compressed);
+    }
+    else {
+        writeStream(cidToGidMap, "", map);
+    }
+
+    writeStream(toUnicode, "",
+        "/CIDInit /ProcSet findresource begin\n"
+        "12 dict begin\n"
+        "begincmap\n"
+        "/CIDSystemInfo << /Registry (Adobe) /Ordering (UCS) /Supplement 0 >> def\n"
+        "/CMapName /Adobe-Identify-UCS def\n"
+        "/CMapType 2 def\n"
+        "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n"
+        "1 beginbfrange\n<0000> <FFFF> <0000>\nendbfrange\n"
+        "endcmap\n"
+        "CMapName currentdict /CMap defineresource pop\n"
+        "end\n"
+        "end");
+
+    std::string descriptor {"<< /Type /FontDescriptor /FontName /GlyphLessFont /Flags 5 /FontBBox [0 0 500 1000]"
+        " /ItalicAngle 0 /Ascent 1000 /Descent -1 /CapHeight 1000 /StemV 80"};
+
+    // Viewers fall back to a substitute font if the font file is missing, the text stays invisible
+    if (!m_font.empty()) {
+        const int fontFileObject {newObject()};
+        m_fontObjects.push_back(fontFileObject);
+        descriptor += " /FontFile2 " + std::to_string(fontFileObject) + " 0 R >>";
+        writeObject(fontDescriptor, descriptor);
+        writeStream(fontFileObject, "/Length1 " + std::to_string(m_font.size()), m_font);
+    }
+    else {
+        std::cerr << "PdfWriter::writeFont: cannot read " << m_fontFileName << std::endl;
+        writeObject(fontDescriptor, descriptor + " >>");
+    }
+}
+
+/**
+ * Converts an UTF-8 string to UTF-16, invalid sequences are skipped.
+ *
+ * @param utf8 The null terminated UTF-8 string.
+ *
+ * @return The UTF-16 string.
+ *
+ * @throws None
+ */
+std::u16string PdfWriter::toUtf16(const char *utf8) {
+    std::u16string utf16;
+    const unsigned char *next {reinterpret_cast<const unsigned char *>(utf8)};
+
+    while (*next != 0) {
+        char32_t codePoint {0};
+        int continuation {0};
+        if (*next < 0x80) {
+            codePoint = *next;
+        }
+        else if ((*next & 0xE0) == 0xC0) {
+            codePoint = *next & 0x1F;
+            continuation = 1;
+        }
+        else if ((*next & 0xF0) == 0xE0) {
+            codePoint = *next & 0x0F;
+            continuation = 2;
+        }
+        else if ((*next & 0xF8) == 0xF0) {
+            codePoint = *next & 0x07;
+            continuation = 3;
+        }
+        else {
+            next++;
+            continue;
+        }
+        next++;
+
+        bool isValid {true};
+        for (int i = 0; i < continuation; i++, next++) {
+            if ((*next & 0xC0) != 0x80) {
+                isValid = false;
+                break;
+            }
+            codePoint = (codePoint << 6) | (*next & 0x3F);
+        }
+        if (!isValid) {
+            continue;
+        }
+
+        if (codePoint >= 0x10000) {
+            codePoint -= 0x10000;
+            utf16 += static_cast<char16_t>(0xD800 + (codePoint >> 10));
+            utf16 += static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+        }
+        else {
+            utf16 += static_cast<char16_t>(codePoint);
+        }
+    }
+    return utf16;
+}
+
+/**
+ * Formats a UTF-16 string as big endian hex digits for a pdf hex string.
+ *
+ * @param text The UTF-16 string.
+ *
+ * @return The hex digits.
+ *
+ * @throws None
+ */
+std::string PdfWriter::hexString(const std::u16string &text) {
+    std::string hex;
+    char digits[5];
+    for (const char16_t c : text) {
+        std::snprintf(digits, sizeof(digits), "%04X", static_cast<unsigned int>(c));
+        hex += digits;
+    }
+    return hex;
+}
+
+/**
+ * Formats a number for the pdf file independent of the locale.
+ *
+ * @param value The number.
+ *
+ * @return The number with at most two decimals.
+ *
+ * @throws None
+ */
+std::string PdfWriter::number(double value) {
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+    stream.setf(std::ios::fixed);
+    stream.precision(2);
+    stream << value;
+    return stream.str();
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
@@ -0,0 +1,181 @@
+#ifndef PDFWRITER_H
+#define PDFWRITER_H
+
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tesseract api
+#include <tesseract/baseapi.h>
+#include <leptonica/allheaders.h>
+
+/*
+    Writes a searchable PDF document page by page.
+    Unlike TessPDFRenderer a page may consist of several images (e.g. mixed raster content)
+    or keep an already compressed image stream. The text layer uses the same glyphless
+    font as TessPDFRenderer, so text selection and search behave the same.
+    Pages are finished by the callers in any order and from any thread, a writer thread
+    appends them to the file in page order.
+    While the document is written, the pages written so far can be previewed: the file up
+    to the last page together with a page tree and cross reference table kept in memory
+    form a complete document.
+    A linearized (fast web view) document is written from the finished document when it
+    is stored under its final name, the file written page by page is never changed.
+*/
+class PdfWriter {
+
+public:
+    // An image XObject covering the whole page
+    struct image {
+        std::string data;
+        std::string filter;
+        std::string decodeParms;
+        std::string colorSpace;
+        std::string decode;
+        int width {0};
+        int height {0};
+        int bitsPerComponent {8};
+        // Image masks are not drawn but referenced as /Mask by another image of the page
+        bool isMask {false};
+        int mask {-1};
+    };
+
+    struct page {
+        double width {0.0};
+        double height {0.0};
+        std::vector<image> images;
+        std::string text;
+    };
+
+    PdfWriter(const std::string &fileName, const std::string &fontFileName);
+    ~PdfWriter();
+
+    bool beginDocument(const std::string &title);
+    void addPage(int pageNumber, page &&pdfPage);
+    void skipPage(int pageNumber);
+    bool endDocument();
+    void setLinearized(bool isLinearized);
+    bool writeLinearized(const std::string &sourceFileName, const std::string &fileName);
+    void setPageWrittenCallback(std::function<void(int)> callback);
+    bool previewData(size_t &length, std::string &tail);
+
+    static image encodeImage(Pix *pix, int type, int quality = 0);
+    static image jpegImage(const std::string &jpegData, int width, int height, int components);
+    static image jbig2Image(Pix *pix);
+    static std::string textLayer(tesseract::TessBaseAPI *api, int imageHeight, int resolution);
+
+private:
+    // The second line marks the file as binary for transfer programs
+    static constexpr const char *cFileHeader = "%PDF-1.5\n%\xB5\xB6\xB7\xB8\n";
+
+    // Objects written by beginDocument
+    enum objects {
+        CATALOG = 1,
+        PAGES = 2,
+        FONT = 3
+    };
+
+    std::ofstream m_file;
+    const std::string m_fileName;
+    const std::string m_fontFileName;
+    std::string m_title;
+    // The glyphless TrueType font, empty if it could not be read
+    std::string m_font;
+
+    size_t m_offset {0};
+    // File offset of every object, index 0 is the free head of the xref table
+    std::vector<size_t> m_objectOffsets {0};
+    std::vector<int> m_pageObjects;
+
+    // Finished pages waiting for their predecessors, skipped pages have no value
+    std::map<int, std::optional<page>> m_pendingPages;
+    int m_nextPage {0};
+    bool m_isEnding {false};
+    std::mutex m_pagesMutex;
+    std::condition_variable m_pagesChanged;
+    std::thread m_writerThread;
+
+    // Objects of a page in file order, the page object first
+    struct pageSection {
+        std::vector<int> objects;
+        int content {0};
+    };
+    std::vector<pageSection> m_pageSections;
+    std::vector<int> m_fontObjects;
+    int m_infoObject {0};
+
+    // Linearized copy: the dictionaries and stream positions of the written objects are kept to write them again
+    // in the order of Annex F, a page of the copy has consecutive object numbers starting with the page object
+    struct objectData {
+        std::string dictionary;
+        size_t dataOffset {0};
+        size_t dataLength {0};
+        bool isStream {false};
+    };
+    struct linearizedPage {
+        int first {0};
+        int objects {0};
+        int content {0};
+    };
+    bool m_isLinearized {false};
+    bool m_isCopying {false};
+    std::vector<objectData> m_objects;
+    // End of every object of the copy
+    std::vector<size_t> m_objectEnds;
+
+    // Called by the writer thread with the number of pages written
+    std::function<void(int)> m_pageWritten;
+    // Length of the file up to the last written page and the end of a document holding these pages
+    size_t m_previewLength {0};
+    std::string m_previewTail;
+
+    void writePages();
+    bool writePage(const page &pdfPage);
+    int newObject();
+    void write(const std::string &data);
+    void writeObject(int object, const std::string &content);
+    void writeStream(int object, const std::string &dictionary, const std::string &data);
+    void writeFont();
+    void writeDocumentStart();
+    void keepObject(int object, objectData &&data);
+    void copyObject(std::ifstream *source, int object, int sourceObject, const std::vector<int> &numbers);
+    std::string hintStream(const std::vector<linearizedPage> &pages, const std::vector<int> &sharedObjects, size_t &sharedOffset) const;
+    std::string xrefEntries(size_t first, size_t end) const;
+    static std::string streamHeader(int object, const std::string &dictionary, size_t length);
+    static std::string renumber(const std::string &dictionary, const std::vector<int> &numbers);
+    static std::string linearizationDictionary(size_t fileLength, size_t hintOffset, size_t hintLength, int firstPageObject,
+                                               size_t firstPageEnd, size_t pageCount, size_t mainXrefEntries);
+    static std::string firstPageTrailer(size_t size, size_t mainXrefOffset, int rootObject, int infoObject);
+    void updatePreview();
+    std::string pageTree() const;
+    std::string crossReference(size_t xrefOffset, int infoObject) const;
+
+    static std::u16string toUtf16(const char *utf8);
+    static std::string hexString(const std::u16string &text);
+    static std::string number(double value);
+};
+
+#endif // PDFWRITER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
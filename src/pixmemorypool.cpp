@@ -0,0 +1,351 @@
+#include "pixmemorypool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Returns the process wide pool instance.
+ *
+ * @return A reference to the PixMemoryPool.
+ *
+ * @throws None
+ */
+PixMemoryPool &PixMemoryPool::instance() {
+    static PixMemoryPool pool;
+    return pool;
+}
+
+/**
+ * Constructs the pool and calculates the buffer size of every size class.
+ *
+ * @throws None
+ */
+PixMemoryPool::PixMemoryPool() {
+    for (int i = 0; i < cSizeClasses; i++) {
+        const double size = static_cast<double>(cMinPooledSize) * std::pow(2.0, static_cast<double>(i) / cClassesPerDoubling);
+        m_classSizes[i] = (static_cast<size_t>(size) + cPageSize - 1) / cPageSize * cPageSize;
+    }
+}
+
+/**
+ * Registers the pool as leptonica's allocator for Pix image data.
+ * Has to be called before the first Pix is created, because buffers allocated before
+ * would otherwise be handed to the pool for deallocation.
+ *
+ * @param memoryLimit The maximum number of bytes the pool may hold, handed out and cached.
+ *
+ * @throws None
+ */
+void PixMemoryPool::install(size_t memoryLimit) {
+    MemoryLimit(memoryLimit);
+    if (!m_isInstalled) {
+        setPixMemoryManager(&PixMemoryPool::allocate, &PixMemoryPool::deallocate);
+        m_isInstalled = true;
+    }
+}
+
+/**
+ * Sets the maximum number of bytes held by the pool and frees cached buffers above it.
+ *
+ * @param memoryLimit The new memory limit in bytes.
+ *
+ * @throws None
+ */
+void PixMemoryPool::MemoryLimit(size_t memoryLimit) {
+    m_memoryLimit = memoryLimit;
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t total = m_bytesInUse + m_bytesCached;
+    if (total > memoryLimit) {
+        releaseCached(total - memoryLimit);
+    }
+}
+
+/**
+ * Returns a snapshot of the allocation statistics.
+ *
+ * @return The statistics of the pool.
+ *
+ * @throws None
+ */
+PixMemoryPool::statistics PixMemoryPool::Statistics() const {
+    statistics stats;
+    stats.allocations = m_allocations;
+    stats.threadCacheHits = m_threadCacheHits;
+    stats.poolHits = m_poolHits;
+    stats.misses = m_misses;
+    stats.bypassed = m_bypassed;
+    stats.bytesInUse = m_bytesInUse;
+    stats.bytesCached = m_bytesCached;
+    stats.peakBytes = m_peakBytes;
+    return stats;
+}
+
+/**
+ * Prints the allocation statistics to the standard output.
+ *
+ * @throws None
+ */
+void PixMemoryPool::printStatistics() const {
+    constexpr size_t MB = 1024 * 1024;
+    const statistics stats = Statistics();
+    std::cout << "PixMemoryPool: " << stats.allocations << " allocations, "
+              << stats.threadCacheHits << " thread cache hits, "
+              << stats.poolHits << " pool hits, "
+              << stats.misses << " misses, "
+              << stats.bypassed << " bypassed, "
+              << stats.bytesInUse / MB << " MB in use, "
+              << stats.bytesCached / MB << " MB cached, "
+              << stats.peakBytes / MB << " MB peak, "
+              << MemoryLimit() / MB << " MB limit" << std::endl;
+}
+
+/**
+ * Frees all buffers in the shared free lists and in the cache of the calling thread.
+ *
+ * @throws None
+ */
+void PixMemoryPool::trim() {
+    threadCache &cache = localCache();
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (int i = 0; i < cSizeClasses; i++) {
+        m_freeBlocks[i].insert(m_freeBlocks[i].end(), cache.blocks[i].begin(), cache.blocks[i].end());
+        cache.blocks[i].clear();
+    }
+    releaseCached(m_bytesCached);
+}
+
+/**
+ * Allocator function registered with leptonica.
+ *
+ * @param size The requested number of bytes.
+ *
+ * @return A pointer to the buffer, nullptr if no memory is available.
+ *
+ * @throws None
+ */
+void *PixMemoryPool::allocate(size_t size) {
+    return instance().allocateBlock(size);
+}
+
+/**
+ * Deallocator function registered with leptonica.
+ *
+ * @param ptr A pointer to a buffer returned by allocate.
+ *
+ * @throws None
+ */
+void PixMemoryPool::deallocate(void *ptr) {
+    instance().deallocateBlock(ptr);
+}
+
+/**
+ * Returns the buffer cache of the calling thread.
+ * When the thread ends, its cached buffers are returned to the shared free lists.
+ *
+ * @return A reference to the thread cache.
+ *
+ * @throws None
+ */
+PixMemoryPool::threadCache &PixMemoryPool::localCache() {
+    thread_local threadCache cache;
+    return cache;
+}
+
+/**
+ * Moves the buffers of an ending thread to the shared free lists.
+ *
+ * @throws None
+ */
+PixMemoryPool::threadCache::~threadCache() {
+    PixMemoryPool &pool = PixMemoryPool::instance();
+    const std::lock_guard<std::mutex> lock(pool.m_mutex);
+    for (int i = 0; i < cSizeClasses; i++) {
+        pool.m_freeBlocks[i].insert(pool.m_freeBlocks[i].end(), blocks[i].begin(), blocks[i].end());
+    }
+}
+
+/**
+ * Returns the smallest size class which can hold the requested size.
+ *
+ * @param size The requested number of bytes.
+ *
+ * @return The index of the size class, -1 if the size is larger than the largest class.
+ *
+ * @throws None
+ */
+int PixMemoryPool::sizeClass(size_t size) const {
+    const auto it = std::lower_bound(m_classSizes.begin(), m_classSizes.end(), size);
+    return (it == m_classSizes.end()) ? -1 : static_cast<int>(it - m_classSizes.begin());
+}
+
+/**
+ * Hands out a buffer of at least the requested size: first from the thread cache,
+ * then from the shared free list and only then from malloc.
+ * Small buffers and buffers which would exceed the memory limit are allocated
+ * directly with malloc and freed again on deallocation.
+ *
+ * @param size The requested number of bytes.
+ *
+ * @return A pointer to the buffer, nullptr if no memory is available.
+ *
+ * @throws None
+ */
+void *PixMemoryPool::allocateBlock(size_t size) {
+    m_allocations++;
+
+    auto unpooledBlock = [](size_t size) -> void * {
+        blockHeader *header = static_cast<blockHeader *>(std::malloc(sizeof(blockHeader) + size));
+        if (header == nullptr) {
+            return nullptr;
+        }
+        header->sizeClass = cUnpooled;
+        header->magic = cMagic;
+        header->capacity = size;
+        return header + 1;
+    };
+
+    auto updatePeak = [this]() {
+        const size_t current = m_bytesInUse;
+        size_t peak = m_peakBytes;
+        while (current > peak && !m_peakBytes.compare_exchange_weak(peak, current)) {}
+    };
+
+    const int index = (size < cMinPooledSize) ? -1 : sizeClass(size);
+    if (index < 0) {
+        if (size >= cMinPooledSize) {
+            m_bypassed++;
+        }
+        return unpooledBlock(size);
+    }
+
+    // Buffer of the same size class freed by this thread
+    std::vector<blockHeader *> &cached = localCache().blocks[index];
+    if (!cached.empty()) {
+        blockHeader *header = cached.back();
+        cached.pop_back();
+        m_bytesCached -= header->capacity;
+        m_bytesInUse += header->capacity;
+        m_threadCacheHits++;
+        updatePeak();
+        return header + 1;
+    }
+
+    const size_t capacity = m_classSizes[index];
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Buffer freed by another thread or an earlier document
+        if (!m_freeBlocks[index].empty()) {
+            blockHeader *header = m_freeBlocks[index].back();
+            m_freeBlocks[index].pop_back();
+            m_bytesCached -= header->capacity;
+            m_bytesInUse += header->capacity;
+            m_poolHits++;
+            updatePeak();
+            return header + 1;
+        }
+
+        // A new buffer is needed, make room for it below the memory limit
+        const size_t total = m_bytesInUse + m_bytesCached;
+        if (total + capacity > m_memoryLimit) {
+            releaseCached(total + capacity - m_memoryLimit);
+        }
+        if (m_bytesInUse + m_bytesCached + capacity > m_memoryLimit) {
+            m_bypassed++;
+            return unpooledBlock(size);
+        }
+        m_bytesInUse += capacity;
+    }
+
+    blockHeader *header = static_cast<blockHeader *>(std::malloc(sizeof(blockHeader) + capacity));
+    if (header == nullptr) {
+        m_bytesInUse -= capacity;
+        return nullptr;
+    }
+    header->sizeClass = static_cast<uint32_t>(index);
+    header->magic = cMagic;
+    header->capacity = capacity;
+    m_misses++;
+    updatePeak();
+    return header + 1;
+}
+
+/**
+ * Takes back a buffer into the thread cache or the shared free list of its size class.
+ * Buffers allocated outside the pool are freed immediately.
+ *
+ * @param ptr A pointer to a buffer returned by allocateBlock.
+ *
+ * @throws None
+ */
+void PixMemoryPool::deallocateBlock(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    blockHeader *header = static_cast<blockHeader *>(ptr) - 1;
+    if (header->magic != cMagic) {
+        // Allocated by leptonica before the pool has been installed
+        std::free(ptr);
+        return;
+    }
+    if (header->sizeClass == cUnpooled) {
+        std::free(header);
+        return;
+    }
+
+    m_bytesInUse -= header->capacity;
+    m_bytesCached += header->capacity;
+
+    std::vector<blockHeader *> &cached = localCache().blocks[header->sizeClass];
+    if (cached.size() < cThreadCacheBlocks) {
+        cached.push_back(header);
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeBlocks[header->sizeClass].push_back(header);
+}
+
+/**
+ * Frees buffers from the shared free lists, largest size classes first,
+ * until at least the given number of bytes has been released.
+ * m_mutex has to be held by the caller.
+ *
+ * @param bytes The number of bytes to release.
+ *
+ * @throws None
+ */
+void PixMemoryPool::releaseCached(size_t bytes) {
+    size_t released {0};
+    for (int i = cSizeClasses - 1; i >= 0 && released < bytes; i--) {
+        while (!m_freeBlocks[i].empty() && released < bytes) {
+            blockHeader *header = m_freeBlocks[i].back();
+            m_freeBlocks[i].pop_back();
+            released += header->capacity;
+            m_bytesCached -= header->capacity;
+            std::free(header);
+        }
+    }
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
@@ -0,0 +1,115 @@
+#ifndef PIXMEMORYPOOL_H
+#define PIXMEMORYPOOL_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <leptonica/allheaders.h>
+
+/*
+    Buffer pool for the image data of leptonica Pix objects.
+    Registered with setPixMemoryManager, it keeps freed page sized buffers in size classes
+    and hands them out again for the next page or document instead of returning them to malloc.
+    Each thread keeps a small cache of its own in front of the shared free lists.
+    The pool never holds more than the memory limit, larger requests bypass the pool.
+*/
+class PixMemoryPool {
+
+public:
+    struct statistics {
+        size_t allocations {0};
+        size_t threadCacheHits {0};
+        size_t poolHits {0};
+        size_t misses {0};
+        size_t bypassed {0};
+        size_t bytesInUse {0};
+        size_t bytesCached {0};
+        size_t peakBytes {0};
+    };
+
+    static PixMemoryPool &instance();
+
+    void install(size_t memoryLimit);
+    void MemoryLimit(size_t memoryLimit);
+    size_t MemoryLimit() const { return m_memoryLimit; };
+
+    statistics Statistics() const;
+    void printStatistics() const;
+    void trim();
+
+private:
+    PixMemoryPool();
+    PixMemoryPool(const PixMemoryPool &) = delete;
+    PixMemoryPool &operator=(const PixMemoryPool &) = delete;
+
+    // Buffers below this size are not worth pooling and come straight from malloc
+    static constexpr size_t cMinPooledSize = 64 * 1024;
+    // Four size classes per power of two keep the unused tail of a buffer below 19%
+    static constexpr int cClassesPerDoubling = 4;
+    static constexpr int cSizeClasses = 64;
+    static constexpr size_t cPageSize = 4096;
+    // Buffers each thread may keep per size class
+    static constexpr size_t cThreadCacheBlocks = 2;
+    static constexpr uint32_t cUnpooled = UINT32_MAX;
+    static constexpr uint32_t cMagic = 0x50495850;
+
+    // Stored in front of every buffer handed to leptonica
+    struct alignas(std::max_align_t) blockHeader {
+        uint32_t sizeClass;
+        uint32_t magic;
+        size_t capacity;
+    };
+
+    struct threadCache {
+        std::array<std::vector<blockHeader *>, cSizeClasses> blocks;
+        ~threadCache();
+    };
+
+    static void *allocate(size_t size);
+    static void deallocate(void *ptr);
+    static threadCache &localCache();
+
+    void *allocateBlock(size_t size);
+    void deallocateBlock(void *ptr);
+    int sizeClass(size_t size) const;
+    void releaseCached(size_t bytes);
+
+    std::array<size_t, cSizeClasses> m_classSizes;
+    std::array<std::vector<blockHeader *>, cSizeClasses> m_freeBlocks;
+    mutable std::mutex m_mutex;
+
+    bool m_isInstalled {false};
+    std::atomic<size_t> m_memoryLimit {0};
+
+    std::atomic<size_t> m_allocations {0};
+    std::atomic<size_t> m_threadCacheHits {0};
+    std::atomic<size_t> m_poolHits {0};
+    std::atomic<size_t> m_misses {0};
+    std::atomic<size_t> m_bypassed {0};
+    std::atomic<size_t> m_bytesInUse {0};
+    std::atomic<size_t> m_bytesCached {0};
+    std::atomic<size_t> m_peakBytes {0};
+};
+
+#endif // PIXMEMORYPOOL_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,165 @@
+#include "prefetcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// local
+#include "transfermanager.h"
+
+/**
+ * Sets the limits of the downloads ahead.
+ *
+ * @param initialLookahead The number of files downloaded ahead until the rates are known.
+ * @param memoryLimit The memory for files downloaded ahead in bytes, 0 to download no file ahead.
+ *
+ * @throws None
+ */
+void Prefetcher::Limits(size_t initialLookahead, size_t memoryLimit) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_initialLookahead = std::clamp<size_t>(initialLookahead, 1, cMaxLookahead);
+    m_memoryLimit = memoryLimit;
+    fill();
+}
+
+/**
+ * Adds a file in processing order, downloads of remote files may start right away.
+ *
+ * @param pdfFile The file.
+ *
+ * @throws None
+ */
+void Prefetcher::add(const std::shared_ptr<PdfFile> &pdfFile) {
+    if (!pdfFile->isRemote()) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(pdfFile);
+    fill();
+}
+
+/**
+ * Called before a file is processed: the file is no longer ahead and the downloads
+ * of the following files are started.
+ *
+ * @param pdfFile The file about to be processed.
+ *
+ * @throws None
+ */
+void Prefetcher::begin(const std::shared_ptr<PdfFile> &pdfFile) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    // Files are mostly processed in the order they were added, a file downloaded early may be taken first
+    const auto ahead {std::find(m_ahead.begin(), m_ahead.end(), pdfFile)};
+    if (ahead != m_ahead.end()) {
+        m_ahead.erase(ahead);
+    }
+    else {
+        const auto pending {std::find(m_pending.begin(), m_pending.end(), pdfFile)};
+        if (pending != m_pending.end()) {
+            m_pending.erase(pending);
+        }
+    }
+    m_beginTime = std::chrono::steady_clock::now();
+    fill();
+}
+
+/**
+ * Called after a file is processed: measures the processing rate of remote files,
+ * the time spent waiting for the download does not count.
+ *
+ * @param pdfFile The processed file.
+ *
+ * @throws None
+ */
+void Prefetcher::end(const std::shared_ptr<PdfFile> &pdfFile) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t size {pdfFile->DownloadedBytes()};
+    if (pdfFile->isRemote() && size > 0) {
+        const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - m_beginTime - pdfFile->DownloadWait()).count()};
+        if (seconds > 0.0) {
+            const double rate {size / seconds};
+            m_processRate = (m_processRate > 0.0) ? (1.0 - cRateWeight) * m_processRate + cRateWeight * rate : rate;
+        }
+        m_fileSize = (1.0 - cRateWeight) * m_fileSize + cRateWeight * size;
+    }
+    fill();
+}
+
+/**
+ * Returns the number of files downloaded ahead of processing at the current rates.
+ *
+ * @return The number of files, 0 if no file is downloaded ahead.
+ *
+ * @throws None
+ */
+size_t Prefetcher::Depth() {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return lookahead();
+}
+
+/**
+ * Returns the number of files to download ahead: enough parallel downloads to deliver
+ * data as fast as it is processed, plus one so the next file is ready in time.
+ *
+ * @return The number of files.
+ *
+ * @throws None
+ */
+size_t Prefetcher::lookahead() const {
+    if (m_memoryLimit == 0) {
+        return 0;
+    }
+    const double downloadRate {TransferManager::instance().DownloadRate()};
+    if (downloadRate <= 0.0 || m_processRate <= 0.0) {
+        return m_initialLookahead;
+    }
+    const double downloads {std::ceil(m_processRate / downloadRate) + 1.0};
+    return static_cast<size_t>(std::clamp(downloads, 1.0, static_cast<double>(cMaxLookahead)));
+}
+
+/**
+ * Starts downloads of pending files up to the lookahead while they fit into the memory limit.
+ * Files whose download is still running count with the average file size.
+ * The first file ahead is always downloaded, however large the files are.
+ *
+ * @throws None
+ */
+void Prefetcher::fill() {
+    const size_t depth {lookahead()};
+    double bytesAhead {0.0};
+    for (const std::shared_ptr<PdfFile> &pdfFile : m_ahead) {
+        bytesAhead += std::max(static_cast<double>(pdfFile->DownloadedBytes()), m_fileSize);
+    }
+
+    while (!m_pending.empty() && m_ahead.size() < depth) {
+        if (!m_ahead.empty() && bytesAhead + m_fileSize > m_memoryLimit) {
+            break;
+        }
+        m_pending.front()->startDownload();
+        m_ahead.push_back(std::move(m_pending.front()));
+        m_pending.pop_front();
+        bytesAhead += m_fileSize;
+    }
+
+    #ifdef DEBUG
+        std::cout << "Prefetcher::fill: lookahead " << depth << ", " << m_ahead.size() << " files ahead, "
+                  << m_pending.size() << " waiting" << std::endl;
+    #endif
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,68 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// local
+#include "pdffile.h"
+
+/*
+    Downloads the next remote files while the current one is processed.
+    Files are handed over in processing order. Before a file is processed, downloads are
+    started for the files after it, as many as needed to keep the processing busy:
+    one more than the ratio of the processing rate to the rate of a single download.
+    Files downloaded ahead are held in memory, their size is limited by the memory limit.
+*/
+class Prefetcher {
+
+public:
+    void add(const std::shared_ptr<PdfFile> &pdfFile);
+    void begin(const std::shared_ptr<PdfFile> &pdfFile);
+    void end(const std::shared_ptr<PdfFile> &pdfFile);
+    void Limits(size_t initialLookahead, size_t memoryLimit);
+    size_t Depth();
+
+private:
+    static constexpr size_t cMaxLookahead = 16;
+    // Assumed size of a file before the first one was processed
+    static constexpr size_t cInitialFileSize = 16 * 1024 * 1024;
+    static constexpr double cRateWeight = 0.3;
+
+    std::mutex m_mutex;
+    // Remote files waiting for their download and files downloaded ahead of processing
+    std::deque<std::shared_ptr<PdfFile>> m_pending;
+    std::deque<std::shared_ptr<PdfFile>> m_ahead;
+
+    size_t m_initialLookahead {1};
+    size_t m_memoryLimit {0};
+
+    // Moving averages of the processed remote files
+    double m_fileSize {cInitialFileSize};
+    double m_processRate {0.0};
+    std::chrono::steady_clock::time_point m_beginTime;
+
+    size_t lookahead() const;
+    void fill();
+};
+
+#endif // PREFETCHER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
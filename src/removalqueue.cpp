@@ -0,0 +1,374 @@
+#include "removalqueue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <signal.h>
+#include <unistd.h>
+
+//Qt 6.x
+#include <QStandardPaths>
+#include <QString>
+
+// local
+#include "ftpconnection.h"
+#include "sessionpool.h"
+
+/**
+ * Returns the process wide removal queue.
+ *
+ * @return A reference to the RemovalQueue.
+ *
+ * @throws None
+ */
+RemovalQueue &RemovalQueue::instance() {
+    static RemovalQueue queue;
+    return queue;
+}
+
+/**
+ * Constructs the queue, takes over the removals left by ended instances and starts removing them.
+ *
+ * @throws None
+ */
+RemovalQueue::RemovalQueue() {
+    // The sessions are borrowed from the SessionPool, so it has to be destroyed after the queue
+    SessionPool::instance();
+    char hostName[256] {};
+    gethostname(hostName, sizeof(hostName) - 1);
+    m_hostName = hostName;
+    const std::filesystem::path directory {(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/removals").toStdString()};
+    m_journalName = directory / (m_hostName + "-" + std::to_string(getpid()) + cJournalExtension);
+    adoptJournals();
+    m_worker = std::thread(&RemovalQueue::run, this);
+}
+
+/**
+ * Stops the queue after the batch being removed, the waiting removals stay in the journal.
+ *
+ * @throws None
+ */
+RemovalQueue::~RemovalQueue() {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_changed.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+/**
+ * Sets the directory processed files are moved to instead of deleting them.
+ * It applies to files queued afterwards.
+ *
+ * @param directory The directory relative to the directory of each file or absolute, empty to delete the files.
+ *
+ * @throws None
+ */
+void RemovalQueue::ArchiveDirectory(const std::string &directory) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_archiveDirectory = directory;
+}
+
+/**
+ * Queues a remote file for removal. The removal is written to the journal before
+ * the call returns, so it is not lost if the program exits. A relative archive directory
+ * is taken relative to the directory the file had before it was claimed.
+ *
+ * @param url The url of the remote file.
+ *
+ * @throws None
+ */
+void RemovalQueue::remove(ParseUrl url) {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        std::string archiveDirectory {m_archiveDirectory};
+        if (!archiveDirectory.empty() && archiveDirectory.front() != '/') {
+            archiveDirectory.insert(0, FtpConnection::unclaimedPath(url.Directory()));
+        }
+        m_pending.push_back({url.Url(), hostOf(url), archiveDirectory});
+        saveJournal();
+    }
+    m_changed.notify_all();
+}
+
+/**
+ * Checks whether a file waits for its removal or is being removed.
+ *
+ * @param url The url of the file.
+ *
+ * @return true if the file is in the queue.
+ *
+ * @throws None
+ */
+bool RemovalQueue::isQueued(const std::string &url) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    const auto isSame = [&url](const removal &item) { return item.url == url; };
+    return std::any_of(m_pending.begin(), m_pending.end(), isSame) || std::any_of(m_running.begin(), m_running.end(), isSame);
+}
+
+/**
+ * Removes the queued files on the worker thread until the queue is stopped.
+ * All waiting removals of the same host and archive directory form one batch,
+ * hosts waiting for a retry are skipped.
+ *
+ * @throws None
+ */
+void RemovalQueue::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_changed.wait(lock, [this] { return m_isStopping || !m_pending.empty(); });
+        // Removals requested shortly after each other are done together
+        if (m_changed.wait_for(lock, cBatchDelay, [this] { return m_isStopping; })) {
+            break;
+        }
+
+        const auto now {std::chrono::steady_clock::now()};
+        auto nextRetry {std::chrono::steady_clock::time_point::max()};
+        auto first {m_pending.end()};
+        for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+            const auto retryTime {m_retryTime.find(it->host)};
+            if (retryTime == m_retryTime.end() || retryTime->second <= now) {
+                first = it;
+                break;
+            }
+            nextRetry = std::min(nextRetry, retryTime->second);
+        }
+        if (first == m_pending.end()) {
+            const size_t count {m_pending.size()};
+            m_changed.wait_until(lock, nextRetry, [this, count] { return m_isStopping || m_pending.size() != count; });
+            if (m_isStopping) {
+                break;
+            }
+            continue;
+        }
+
+        const std::string host {first->host};
+        const std::string archiveDirectory {first->archiveDirectory};
+        for (auto it = first; it != m_pending.end();) {
+            if (it->host == host && it->archiveDirectory == archiveDirectory) {
+                m_running.push_back(std::move(*it));
+                it = m_pending.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        std::vector<removal> batch {m_running};
+        std::vector<removal> retries;
+        lock.unlock();
+        removeBatch(batch, retries);
+        lock.lock();
+
+        m_running.clear();
+        if (retries.empty()) {
+            m_failures.erase(host);
+            m_retryTime.erase(host);
+        }
+        else {
+            const int failures {std::min(++m_failures[host], 16)};
+            const auto delay {std::min<std::chrono::seconds>(cRetryDelay * (1 << (failures - 1)), cMaxRetryDelay)};
+            m_retryTime[host] = std::chrono::steady_clock::now() + delay;
+            std::cerr << "Removing files on " << host << " failed, retrying in " << delay.count() << " s" << std::endl;
+            m_pending.insert(m_pending.begin(), std::make_move_iterator(retries.begin()), std::make_move_iterator(retries.end()));
+        }
+        saveJournal();
+    }
+}
+
+/**
+ * Removes a batch of files of one host over one session.
+ * A file already gone counts as removed. A file the server refuses to remove is
+ * reported and dropped, retrying would not change the answer.
+ *
+ * @param batch The removals, all of the same host and archive directory.
+ * @param retries Receives the removals not done because the connection failed.
+ *
+ * @throws None
+ */
+void RemovalQueue::removeBatch(std::vector<removal> &batch, std::vector<removal> &retries) {
+    std::vector<std::string> paths;
+    paths.reserve(batch.size());
+    for (const removal &item : batch) {
+        paths.push_back(ParseUrl(item.url).FileDir());
+    }
+
+    std::vector<int> errors;
+    FtpConnection ftpConnection(ParseUrl(batch.front().url));
+    const bool isConnected {ftpConnection.removeFiles(paths, batch.front().archiveDirectory, errors)};
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (errors[i] == SSH_FX_OK || errors[i] == SSH_FX_NO_SUCH_FILE) {
+            #ifdef DEBUG
+                std::cout << "RemovalQueue::removeBatch: removed " << paths[i] << std::endl;
+            #endif
+        }
+        else if (!isConnected) {
+            retries.push_back(std::move(batch[i]));
+        }
+        else {
+            std::cerr << "Could not remove " << paths[i] << " on " << batch[i].host << ", error " << errors[i] << std::endl;
+        }
+    }
+}
+
+/**
+ * Takes over the journals of instances on this host whose process is gone, and the journal
+ * of versions keeping one journal for all instances. A journal is renamed before it is read,
+ * so of several instances starting at the same time only one takes it over. The removals
+ * are in the journal of this instance before the taken over journal is removed.
+ *
+ * @throws None
+ */
+void RemovalQueue::adoptJournals() {
+    const std::filesystem::path directory {m_journalName.parent_path()};
+    std::vector<std::filesystem::path> journals;
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    const std::filesystem::path sharedJournal {directory.parent_path() / "removals.journal"};
+    if (std::filesystem::exists(sharedJournal, error)) {
+        journals.push_back(sharedJournal);
+    }
+    for (const auto &file : std::filesystem::directory_iterator(directory, error)) {
+        // Journals are named <host name>-<pid>.journal
+        const std::string name {file.path().filename().string()};
+        const size_t dash {name.rfind('-')};
+        if (file.path().extension() != cJournalExtension || dash != m_hostName.size() || name.compare(0, dash, m_hostName) != 0) {
+            continue;
+        }
+        const pid_t pid {static_cast<pid_t>(std::atol(name.c_str() + dash + 1))};
+        // A journal of this pid was left by an ended process before the pid was reused
+        if (pid > 0 && (pid == getpid() || (kill(pid, 0) != 0 && errno == ESRCH))) {
+            journals.push_back(file.path());
+        }
+    }
+
+    // Named like journals of this instance, so they are taken over again if it ends before they are removed
+    std::vector<std::filesystem::path> adopted;
+    int counter {0};
+    for (const std::filesystem::path &journal : journals) {
+        std::filesystem::path adoptedName;
+        do {
+            adoptedName = directory / (m_hostName + "-" + std::to_string(getpid()) + "." + std::to_string(counter++) + cJournalExtension);
+        } while (std::filesystem::exists(adoptedName, error) || std::find(journals.begin(), journals.end(), adoptedName) != journals.end());
+        std::filesystem::rename(journal, adoptedName, error);
+        if (!error) {
+            loadJournal(adoptedName);
+            adopted.push_back(adoptedName);
+        }
+    }
+    if (adopted.empty()) {
+        return;
+    }
+
+    saveJournal();
+    for (const std::filesystem::path &journal : adopted) {
+        std::filesystem::remove(journal, error);
+    }
+    #ifdef DEBUG
+        std::cout << "RemovalQueue::adoptJournals: " << m_pending.size() << " removals from " << adopted.size() << " journals" << std::endl;
+    #endif
+}
+
+/**
+ * Reads the removals of a journal.
+ *
+ * @param journalName The journal.
+ *
+ * @throws None
+ */
+void RemovalQueue::loadJournal(const std::filesystem::path &journalName) {
+    std::ifstream file(journalName, std::ios::in | std::ios::binary);
+    std::string header;
+    if (!file || !std::getline(file, header) || header != cHeader) {
+        return;
+    }
+
+    std::string record;
+    while (std::getline(file, record, '\0')) {
+        const size_t tab {record.find('\t')};
+        if (tab == std::string::npos) {
+            continue;
+        }
+        ParseUrl url(record.substr(tab + 1));
+        m_pending.push_back({record.substr(tab + 1), hostOf(url), record.substr(0, tab)});
+    }
+}
+
+/**
+ * Stores the waiting and running removals, called with the mutex held. The journal is
+ * written to a temporary file first, so an interrupted write leaves the previous one intact.
+ * Both carry the process id, no other instance writes them.
+ * It is readable by the owner only, the urls may contain passwords.
+ *
+ * @throws None
+ */
+void RemovalQueue::saveJournal() const {
+    std::error_code error;
+    if (m_pending.empty() && m_running.empty()) {
+        std::filesystem::remove(m_journalName, error);
+        return;
+    }
+
+    std::filesystem::path temporaryName {m_journalName};
+    temporaryName += ".tmp";
+    std::filesystem::create_directories(m_journalName.parent_path(), error);
+
+    std::ofstream file(temporaryName, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::filesystem::permissions(temporaryName, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, error);
+    file << cHeader << '\n';
+    for (const removal &item : m_running) {
+        file << item.archiveDirectory << '\t' << item.url << '\0';
+    }
+    for (const removal &item : m_pending) {
+        file << item.archiveDirectory << '\t' << item.url << '\0';
+    }
+    file.close();
+    if (!file) {
+        std::cerr << "Error writing removal journal " << temporaryName << std::endl;
+        std::filesystem::remove(temporaryName, error);
+        return;
+    }
+
+    std::filesystem::rename(temporaryName, m_journalName, error);
+    if (error) {
+        std::cerr << "Error writing removal journal " << m_journalName << ": " << error.message() << std::endl;
+    }
+}
+
+/**
+ * Returns the key of the server of a url, the removals of one key share a session.
+ *
+ * @param url The url.
+ *
+ * @return The user, host and port.
+ *
+ * @throws None
+ */
+std::string RemovalQueue::hostOf(const ParseUrl &url) {
+    return url.Username() + "@" + url.Host() + ":" + std::to_string(url.Port());
+}
+
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -0,0 +1,98 @@
+#ifndef REMOVALQUEUE_H
+#define REMOVALQUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// local
+#include "parseurl.h"
+
+/*
+    Process wide queue of remote files to remove after they were processed.
+    The files are removed on a thread of their own, so renaming a file does not wait for
+    the server. Removals requested within cBatchDelay are done together over one session
+    per host, deleting the files or moving them into the archive directory.
+    The queue is kept in a journal of this instance, named after the host and process id,
+    so instances running at the same time do not overwrite each other's removals. Removals
+    left at exit are done on the next start, which takes over the journals of ended instances
+    on this host.
+    A host which cannot be reached is retried after a delay growing with every failure.
+*/
+class RemovalQueue {
+
+public:
+    static RemovalQueue &instance();
+
+    void remove(ParseUrl url);
+    bool isQueued(const std::string &url);
+    void ArchiveDirectory(const std::string &directory);
+
+private:
+    RemovalQueue();
+    ~RemovalQueue();
+    RemovalQueue(const RemovalQueue &) = delete;
+    RemovalQueue &operator=(const RemovalQueue &) = delete;
+
+    struct removal {
+        std::string url;
+        std::string host;
+        std::string archiveDirectory;
+    };
+
+    static constexpr std::chrono::seconds cBatchDelay {2};
+    static constexpr std::chrono::seconds cRetryDelay {5};
+    static constexpr std::chrono::seconds cMaxRetryDelay {300};
+    static constexpr const char *cHeader = "scan2ocr removals 1";
+    static constexpr const char *cJournalExtension = ".journal";
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_isStopping {false};
+    std::string m_archiveDirectory;
+    std::string m_hostName;
+    std::filesystem::path m_journalName;
+
+    // Removals waiting and the batch being removed, both are kept in the journal
+    std::deque<removal> m_pending;
+    std::vector<removal> m_running;
+
+    // Hosts which failed, with the number of failures in a row and the time of the next attempt
+    std::map<std::string, int> m_failures;
+    std::map<std::string, std::chrono::steady_clock::time_point> m_retryTime;
+
+    // Started last, after all members are initialized
+    std::thread m_worker;
+
+    void run();
+    void removeBatch(std::vector<removal> &batch, std::vector<removal> &retries);
+    void adoptJournals();
+    void loadJournal(const std::filesystem::path &journalName);
+    void saveJournal() const;
+    static std::string hostOf(const ParseUrl &url);
+};
+
+#endif // REMOVALQUEUE_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
@@ -8,6 +8,11 @@
 #include <QResource>
 #include <QTranslator>
 #include "mainwindow.h"
+#include "pixmemorypool.h"
+#include "sessionpool.h"
+#include "transfermanager.h"
+#include "downloadcache.h"
+#include "removalqueue.h"
 
 namespace constants {
     const std::string PathDestination = []() {
@@ -61,6 +66,15 @@ int main (int argc,char **argv){
     #endif
     QCoreApplication::setOrganizationName("scan2ocr");
 
+    // Pool the image buffers of all pages, has to be installed before the first Pix is created
+    Settings settings;
+    PixMemoryPool::instance().install(static_cast<size_t>(settings.PixPoolLimit()) * 1024 * 1024);
+    SessionPool::instance().Limits(settings.ConnectionsPerHost(), settings.ConnectionIdleTimeout());
+    TransferManager::instance().Limits(settings.ConcurrentTransfers(), settings.ConnectionsPerHost(),
+                                       settings.BandwidthLimit(), settings.HostBandwidthLimit());
+    DownloadCache::instance().Limit(static_cast<uint64_t>(settings.DownloadCacheLimit()) * 1024 * 1024);
+    RemovalQueue::instance().ArchiveDirectory(settings.RemoteArchiveDir().toStdString());
+
     MainWindow mainWindow;
     mainWindow.show();
     return app.exec();
@@ -0,0 +1,454 @@
+#include "sessionpool.h"
+
+#include <algorithm>
+#include <iostream>
+
+// local
+#include "settings.h"
+
+/**
+ * Returns the process wide pool instance.
+ *
+ * @return A reference to the SessionPool.
+ *
+ * @throws None
+ */
+SessionPool &SessionPool::instance() {
+    static SessionPool pool;
+    return pool;
+}
+
+/**
+ * Constructs the pool and starts the thread closing idle sessions.
+ *
+ * @throws None
+ */
+SessionPool::SessionPool() {
+    // Started after all members are initialized
+    m_reaper = std::thread(&SessionPool::reap, this);
+}
+
+/**
+ * Stops the idle thread and closes all idle sessions.
+ *
+ * @throws None
+ */
+SessionPool::~SessionPool() {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_wakeReaper.notify_all();
+    m_reaper.join();
+    closeIdle();
+}
+
+/**
+ * Sets the limits of the pool, idle sessions above the new limit are closed by the idle thread.
+ *
+ * @param connectionsPerHost The maximum number of sessions to one host at the same time.
+ * @param idleTimeout Seconds an unused session is kept open, 0 to close sessions right after use.
+ *
+ * @throws None
+ */
+void SessionPool::Limits(int connectionsPerHost, int idleTimeout) {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_connectionsPerHost = std::max(connectionsPerHost, 1);
+        m_idleTimeout = std::chrono::seconds(std::max(idleTimeout, 0));
+    }
+    m_released.notify_all();
+    m_wakeReaper.notify_all();
+}
+
+/**
+ * Lends out an authenticated session to the host. An idle session is reused if it is still
+ * alive, otherwise a new one is connected. Blocks while the host's session limit is reached.
+ *
+ * @param host The remote host.
+ * @param port The ssh port, 0 for the default port.
+ * @param username The user to log in as.
+ * @param password The password, used if the public key authentication fails.
+ *
+ * @return The lease holding the session, empty if no connection could be established.
+ *
+ * @throws None
+ */
+SessionPool::Lease SessionPool::acquire(const std::string &host, int port, const std::string &username, const std::string &password) {
+    return lend(host, port, username, password, true);
+}
+
+/**
+ * Lends out a session like acquire(), but returns right away with an empty lease
+ * instead of waiting if the host's session limit is reached.
+ *
+ * @param host The remote host.
+ * @param port The ssh port, 0 for the default port.
+ * @param username The user to log in as.
+ * @param password The password, used if the public key authentication fails.
+ *
+ * @return The lease holding the session, empty if the limit is reached or no connection could be established.
+ *
+ * @throws None
+ */
+SessionPool::Lease SessionPool::tryAcquire(const std::string &host, int port, const std::string &username, const std::string &password) {
+    return lend(host, port, username, password, false);
+}
+
+/**
+ * Lends out an idle session or connects a new one.
+ *
+ * @param host The remote host.
+ * @param port The ssh port, 0 for the default port.
+ * @param username The user to log in as.
+ * @param password The password, used if the public key authentication fails.
+ * @param isWaiting Flag indicating whether to wait for a returned session at the host's session limit.
+ *
+ * @return The lease holding the session, empty if none could be lent out.
+ *
+ * @throws None
+ */
+SessionPool::Lease SessionPool::lend(const std::string &host, int port, const std::string &username, const std::string &password, bool isWaiting) {
+    const std::string key {username + "@" + host + ":" + std::to_string(port)};
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SessionPool::host &entry = m_hosts[key];
+    while (true) {
+        // Most recently used sessions first, old ones may be closed by the idle thread soon
+        while (!entry.idle.empty()) {
+            std::unique_ptr<connection> candidate {std::move(entry.idle.back())};
+            entry.idle.pop_back();
+            entry.borrowed++;
+
+            lock.unlock();
+            const bool isAlive {isHealthy(*candidate)};
+            if (isAlive) {
+                return Lease(this, key, std::move(candidate));
+            }
+            #ifdef DEBUG
+                std::cout << "SessionPool::lend: dropping dead session to " << key << std::endl;
+            #endif
+            close(candidate);
+            lock.lock();
+            entry.borrowed--;
+        }
+
+        if (entry.borrowed < m_connectionsPerHost) {
+            break;
+        }
+        if (!isWaiting) {
+            return Lease();
+        }
+        m_released.wait(lock);
+    }
+
+    // Connect without holding the lock, the handshake takes a few round trips
+    entry.borrowed++;
+    lock.unlock();
+    std::unique_ptr<connection> newConnection {connect(host, port, username, password)};
+    if (newConnection == nullptr) {
+        lock.lock();
+        entry.borrowed--;
+        lock.unlock();
+        m_released.notify_one();
+        return Lease();
+    }
+    #ifdef DEBUG
+        std::cout << "SessionPool::lend: new session to " << key << std::endl;
+    #endif
+    return Lease(this, key, std::move(newConnection));
+}
+
+/**
+ * Takes a session back from a lease, keeps it for reuse if it is valid.
+ *
+ * @param key The host key of the session.
+ * @param connection The returned session.
+ * @param isValid false if the session is broken and has to be closed.
+ *
+ * @throws None
+ */
+void SessionPool::release(const std::string &key, std::unique_ptr<connection> connection, bool isValid) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    host &entry = m_hosts[key];
+    entry.borrowed--;
+    if (isValid && !m_isStopping && m_idleTimeout.count() > 0) {
+        connection->lastUsed = std::chrono::steady_clock::now();
+        entry.idle.push_back(std::move(connection));
+    }
+    lock.unlock();
+    m_released.notify_one();
+
+    if (connection != nullptr) {
+        close(connection);
+    }
+}
+
+/**
+ * Closes all idle sessions, sessions lent out are closed when they are returned.
+ *
+ * @throws None
+ */
+void SessionPool::closeIdle() {
+    std::vector<std::unique_ptr<connection>> closing;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &[key, entry] : m_hosts) {
+            for (std::unique_ptr<connection> &idleConnection : entry.idle) {
+                closing.push_back(std::move(idleConnection));
+            }
+            entry.idle.clear();
+        }
+    }
+    for (std::unique_ptr<connection> &idleConnection : closing) {
+        close(idleConnection);
+    }
+}
+
+/**
+ * Runs in the idle thread: closes sessions unused for longer than the idle timeout
+ * and idle sessions above the per host limit.
+ *
+ * @throws None
+ */
+void SessionPool::reap() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopping) {
+        const std::chrono::seconds interval {std::clamp(m_idleTimeout / 2, std::chrono::seconds(1), std::chrono::seconds(30))};
+        m_wakeReaper.wait_for(lock, interval);
+        if (m_isStopping) {
+            break;
+        }
+
+        const auto now {std::chrono::steady_clock::now()};
+        std::vector<std::unique_ptr<connection>> closing;
+        for (auto &[key, entry] : m_hosts) {
+            // The oldest sessions are at the front
+            size_t expired {0};
+            while (expired < entry.idle.size() && now - entry.idle[expired]->lastUsed >= m_idleTimeout) {
+                expired++;
+            }
+            const int count {static_cast<int>(entry.idle.size()) + entry.borrowed};
+            if (count > m_connectionsPerHost) {
+                expired = std::max(expired, std::min(entry.idle.size(), static_cast<size_t>(count - m_connectionsPerHost)));
+            }
+            for (size_t i = 0; i < expired; i++) {
+                closing.push_back(std::move(entry.idle[i]));
+            }
+            entry.idle.erase(entry.idle.begin(), entry.idle.begin() + expired);
+        }
+
+        if (!closing.empty()) {
+            lock.unlock();
+            #ifdef DEBUG
+                std::cout << "SessionPool::reap: closing " << closing.size() << " idle sessions" << std::endl;
+            #endif
+            for (std::unique_ptr<connection> &idleConnection : closing) {
+                close(idleConnection);
+            }
+            lock.lock();
+        }
+    }
+}
+
+/**
+ * Establishes and authenticates a new session and opens its SFTP channel.
+ *
+ * @param host The remote host.
+ * @param port The ssh port, 0 for the default port.
+ * @param username The user to log in as, empty for the local user.
+ * @param password The password, used if the public key authentication fails.
+ *
+ * @return The new session, nullptr on failure.
+ *
+ * @throws None
+ */
+std::unique_ptr<SessionPool::connection> SessionPool::connect(const std::string &host, int port, const std::string &username, const std::string &password) {
+    std::unique_ptr<connection> newConnection {std::make_unique<connection>()};
+    newConnection->session = ssh_new();
+    if (newConnection->session == nullptr) {
+        return nullptr;
+    }
+    ssh_session session {newConnection->session};
+
+    ssh_options_set(session, SSH_OPTIONS_HOST, host.c_str());
+    if (port > 0) {
+        ssh_options_set(session, SSH_OPTIONS_PORT, &port);
+    }
+    if (!username.empty()) {
+        ssh_options_set(session, SSH_OPTIONS_USER, username.c_str());
+    }
+    long timeout {cNetworkTimeout};
+    ssh_options_set(session, SSH_OPTIONS_TIMEOUT, &timeout);
+
+    Settings settings;
+    const std::string keyPath {settings.SSHKeyPath().toStdString()};
+    ssh_options_set(session, SSH_OPTIONS_IDENTITY, keyPath.c_str());
+
+    int rc = ssh_connect(session);
+    if (rc != SSH_OK) {
+        std::cerr << "Error connecting to FTP server: " << ssh_get_error(session) << std::endl;
+        close(newConnection);
+        return nullptr;
+    }
+
+    // Verify the server's host key
+    ssh_key server_pubkey;
+    rc = ssh_get_server_publickey(session, &server_pubkey);
+    if (rc == SSH_OK) {
+        ssh_key_free(server_pubkey);
+    } else {
+        std::cerr << "Server's host key is not known." << std::endl;
+        close(newConnection);
+        return nullptr;
+    }
+
+    // First try to authenticate with the server using ssh-keys
+    rc = ssh_userauth_publickey_auto(session, NULL, keyPath.c_str());
+    if (rc != SSH_AUTH_SUCCESS) {
+        // Authentication using keys failed, try user/password
+        rc = ssh_userauth_password(session, NULL, password.c_str());
+        if (rc != SSH_AUTH_SUCCESS) {
+            // Also user/password authentication failed, give up
+            std::cerr << "Error connecting to FTP server: " << ssh_get_error(session) << std::endl;
+            close(newConnection);
+            return nullptr;
+        }
+    }
+
+    // Open an SFTP session
+    newConnection->sftp = sftp_new(session);
+    if (newConnection->sftp == nullptr || sftp_init(newConnection->sftp) != SSH_OK) {
+        std::cerr << "Error initializing SFTP session: " << ssh_get_error(session) << std::endl;
+        close(newConnection);
+        return nullptr;
+    }
+    return newConnection;
+}
+
+/**
+ * Closes the SFTP channel and the session and frees the connection.
+ *
+ * @param connection The connection to close, nullptr afterwards.
+ *
+ * @throws None
+ */
+void SessionPool::close(std::unique_ptr<connection> &connection) {
+    if (connection == nullptr) {
+        return;
+    }
+    if (connection->sftp != nullptr) {
+        sftp_free(connection->sftp);
+    }
+    if (connection->session != nullptr) {
+        ssh_disconnect(connection->session);
+        ssh_free(connection->session);
+    }
+    connection.reset();
+}
+
+/**
+ * Checks whether an idle session can still be used. Sessions used within the last
+ * few seconds are trusted, older ones have to answer a stat request.
+ *
+ * @param connection The idle session.
+ *
+ * @return true if the session is alive.
+ *
+ * @throws None
+ */
+bool SessionPool::isHealthy(connection &connection) {
+    if (connection.session == nullptr || connection.sftp == nullptr || !ssh_is_connected(connection.session)) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() - connection.lastUsed < cHealthCheckAge) {
+        return true;
+    }
+    sftp_attributes attributes {sftp_stat(connection.sftp, ".")};
+    if (attributes == nullptr) {
+        return false;
+    }
+    sftp_attributes_free(attributes);
+    return true;
+}
+
+/******************** class SessionPool::Lease *********************/
+
+/**
+ * Constructs a lease of a session, only used by the pool.
+ *
+ * @param pool The pool the session is returned to.
+ * @param key The host key of the session.
+ * @param connection The lent out session.
+ *
+ * @throws None
+ */
+SessionPool::Lease::Lease(SessionPool *pool, const std::string &key, std::unique_ptr<connection> connection)
+    : m_pool(pool), m_key(key), m_connection(std::move(connection)) {
+}
+
+/**
+ * Returns the session to the pool.
+ *
+ * @throws None
+ */
+SessionPool::Lease::~Lease() {
+    release();
+}
+
+SessionPool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool), m_key(std::move(other.m_key)), m_connection(std::move(other.m_connection)), m_isValid(other.m_isValid) {
+    other.m_pool = nullptr;
+}
+
+SessionPool::Lease &SessionPool::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_key = std::move(other.m_key);
+        m_connection = std::move(other.m_connection);
+        m_isValid = other.m_isValid;
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * Marks the session as broken, it is closed instead of being reused when it is returned.
+ *
+ * @throws None
+ */
+void SessionPool::Lease::invalidate() {
+    m_isValid = false;
+}
+
+/**
+ * Returns the session to the pool before the lease goes out of scope.
+ *
+ * @throws None
+ */
+void SessionPool::Lease::release() {
+    if (m_pool != nullptr && m_connection != nullptr) {
+        m_pool->release(m_key, std::move(m_connection), m_isValid);
+    }
+    m_pool = nullptr;
+    m_connection.reset();
+    m_isValid = true;
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
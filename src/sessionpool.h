@@ -0,0 +1,120 @@
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libssh/libssh.h>
+#include <libssh/sftp.h>
+
+/*
+    Process wide pool of authenticated SSH sessions with an initialized SFTP channel.
+    Sessions are kept per host, port and user and lent out as a Lease, which returns
+    the session to the pool when it goes out of scope. At most connectionsPerHost sessions
+    per host exist at the same time, further requests wait for a returned session.
+    Sessions idle for longer than the idle timeout are closed by a background thread,
+    sessions idle for more than a few seconds are checked with a round trip before reuse.
+*/
+class SessionPool {
+
+private:
+    struct connection {
+        ssh_session session {nullptr};
+        sftp_session sftp {nullptr};
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        ssh_session Session() const { return m_connection ? m_connection->session : nullptr; };
+        sftp_session Sftp() const { return m_connection ? m_connection->sftp : nullptr; };
+        explicit operator bool() const { return m_connection != nullptr; };
+
+        void invalidate();
+        void release();
+
+    private:
+        friend class SessionPool;
+        Lease(SessionPool *pool, const std::string &key, std::unique_ptr<connection> connection);
+
+        SessionPool *m_pool {nullptr};
+        std::string m_key;
+        std::unique_ptr<connection> m_connection;
+        bool m_isValid {true};
+    };
+
+    static SessionPool &instance();
+
+    Lease acquire(const std::string &host, int port, const std::string &username, const std::string &password);
+    Lease tryAcquire(const std::string &host, int port, const std::string &username, const std::string &password);
+    void Limits(int connectionsPerHost, int idleTimeout);
+    void closeIdle();
+
+private:
+    SessionPool();
+    ~SessionPool();
+    SessionPool(const SessionPool &) = delete;
+    SessionPool &operator=(const SessionPool &) = delete;
+
+    // Sessions idle for longer are checked with a round trip before they are lent out again
+    static constexpr std::chrono::seconds cHealthCheckAge {5};
+    // Blocking libssh calls on a dead connection give up after this time
+    static constexpr long cNetworkTimeout = 30;
+
+    struct host {
+        std::vector<std::unique_ptr<connection>> idle;
+        // Sessions lent out or being connected
+        int borrowed {0};
+    };
+
+    std::map<std::string, host> m_hosts;
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::condition_variable m_wakeReaper;
+    std::thread m_reaper;
+    bool m_isStopping {false};
+
+    int m_connectionsPerHost {4};
+    std::chrono::seconds m_idleTimeout {60};
+
+    static std::unique_ptr<connection> connect(const std::string &host, int port, const std::string &username, const std::string &password);
+    static void close(std::unique_ptr<connection> &connection);
+    static bool isHealthy(connection &connection);
+
+    Lease lend(const std::string &host, int port, const std::string &username, const std::string &password, bool isWaiting);
+    void release(const std::string &key, std::unique_ptr<connection> connection, bool isValid);
+    void reap();
+};
+
+#endif // SESSIONPOOL_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
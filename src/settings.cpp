@@ -33,6 +33,10 @@ void Settings::readValues() {
         newNetworkProfile.documentProfileName = settings.value("documentProfileName").toString().toStdString();
         newNetworkProfile.documentProfileIndex = settings.value("documentProfileIndex").toInt();
         newNetworkProfile.url = ParseUrl(settings.value("url").toString().toStdString());
+        newNetworkProfile.isRemoteFind = settings.value("isRemoteFind", false).toBool();
+        newNetworkProfile.isIncremental = settings.value("isIncremental", false).toBool();
+        newNetworkProfile.isClaiming = settings.value("isClaiming", false).toBool();
+        newNetworkProfile.isPolling = settings.value("isPolling", false).toBool();
         networkProfiles.emplace_back(std::make_unique<Settings::networkProfile>(newNetworkProfile));
         settings.endGroup();
     }
@@ -54,6 +58,10 @@ void Settings::readValues() {
         newDocumentProfile.resolution = settings.value("resolution").toInt();
         newDocumentProfile.thresholdValue = settings.value("thresholdValue").toFloat();
         newDocumentProfile.isColored = settings.value("isColored").toBool();
+        newDocumentProfile.cropBorders = settings.value("cropBorders", true).toBool();
+        newDocumentProfile.mixedRasterContent = settings.value("mixedRasterContent", false).toBool();
+        newDocumentProfile.jbig2 = settings.value("jbig2", false).toBool();
+        newDocumentProfile.linearized = settings.value("linearized", false).toBool();
 
         if (newDocumentProfile.name.empty()) {
             newDocumentProfile.name = "default";
@@ -61,6 +69,10 @@ void Settings::readValues() {
             newDocumentProfile.resolution = 600;
             newDocumentProfile.thresholdValue = 0.993;
             newDocumentProfile.isColored = false;    
+            newDocumentProfile.cropBorders = true;
+            newDocumentProfile.mixedRasterContent = false;
+            newDocumentProfile.jbig2 = false;
+            newDocumentProfile.linearized = false;
         }
         documentProfiles.emplace_back(std::make_unique<Settings::documentProfile>(newDocumentProfile));
         settings.endGroup();
@@ -78,6 +90,21 @@ void Settings::readValues() {
     settings.beginGroup("Path");
     m_destinationDir = settings.value("DestinationDir").toString();
     m_sshKeyPath = settings.value("SSHKeyPath").toString();
+    m_remoteArchiveDir = settings.value("RemoteArchiveDir").toString();
+    settings.endGroup();
+
+    // Read performance settings
+    settings.beginGroup("Performance");
+    m_pixPoolLimit = settings.value("PixPoolLimit", 2048).toInt();
+    m_ocrThreads = settings.value("OcrThreads", 0).toInt();
+    m_memoryFileLimit = settings.value("MemoryFileLimit", 0).toInt();
+    m_connectionsPerHost = settings.value("ConnectionsPerHost", 4).toInt();
+    m_connectionIdleTimeout = settings.value("ConnectionIdleTimeout", 60).toInt();
+    m_concurrentTransfers = settings.value("ConcurrentTransfers", 4).toInt();
+    m_bandwidthLimit = settings.value("BandwidthLimit", 0).toInt();
+    m_hostBandwidthLimit = settings.value("HostBandwidthLimit", 0).toInt();
+    m_prefetchLimit = settings.value("PrefetchLimit", 1024).toInt();
+    m_downloadCacheLimit = settings.value("DownloadCacheLimit", 2048).toInt();
     settings.endGroup();
 
     if (m_destinationDir.isEmpty()) {
@@ -109,6 +136,10 @@ void Settings::saveValues() {
         settings.setValue("documentProfileName", QString::fromStdString(profile->documentProfileName));
         settings.setValue("documentProfileIndex", profile->documentProfileIndex);
         settings.setValue("url", QString::fromStdString(profile->url.Url()));
+        settings.setValue("isRemoteFind", profile->isRemoteFind);
+        settings.setValue("isIncremental", profile->isIncremental);
+        settings.setValue("isClaiming", profile->isClaiming);
+        settings.setValue("isPolling", profile->isPolling);
         settings.endGroup();
     }
     settings.endGroup();
@@ -122,6 +153,10 @@ void Settings::saveValues() {
         settings.setValue("resolution", documentProfiles[i]->resolution);
         settings.setValue("thresholdValue", documentProfiles[i]->thresholdValue);
         settings.setValue("isColored", documentProfiles[i]->isColored);
+        settings.setValue("cropBorders", documentProfiles[i]->cropBorders);
+        settings.setValue("mixedRasterContent", documentProfiles[i]->mixedRasterContent);
+        settings.setValue("jbig2", documentProfiles[i]->jbig2);
+        settings.setValue("linearized", documentProfiles[i]->linearized);
         settings.endGroup();
         settings.sync();
     }
@@ -131,6 +166,21 @@ void Settings::saveValues() {
     settings.beginGroup("Path");
     settings.setValue("DestinationDir", m_destinationDir);
     settings.setValue("SSHKeyPath", m_sshKeyPath);
+    settings.setValue("RemoteArchiveDir", m_remoteArchiveDir);
+    settings.endGroup();
+
+    // performance
+    settings.beginGroup("Performance");
+    settings.setValue("PixPoolLimit", m_pixPoolLimit);
+    settings.setValue("OcrThreads", m_ocrThreads);
+    settings.setValue("MemoryFileLimit", m_memoryFileLimit);
+    settings.setValue("ConnectionsPerHost", m_connectionsPerHost);
+    settings.setValue("ConnectionIdleTimeout", m_connectionIdleTimeout);
+    settings.setValue("ConcurrentTransfers", m_concurrentTransfers);
+    settings.setValue("BandwidthLimit", m_bandwidthLimit);
+    settings.setValue("HostBandwidthLimit", m_hostBandwidthLimit);
+    settings.setValue("PrefetchLimit", m_prefetchLimit);
+    settings.setValue("DownloadCacheLimit", m_downloadCacheLimit);
     settings.endGroup();
 }
 
@@ -289,8 +339,153 @@ void Settings::SSHKeyPath(const QString &dir) {
  */
 void Settings::DestinationDir(const QString &dir) {
     m_destinationDir = dir;
+}
+
+/**
+ * Sets the directory on the server where processed remote files are moved to.
+ *
+ * @param dir The directory, relative to the directory of the file or absolute, empty to delete the files.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::RemoteArchiveDir(const QString &dir) {
+    m_remoteArchiveDir = dir;
 }   
 
+/*********************** Performance **************************/
+
+/**
+ * Sets the memory limit of the image buffer pool.
+ *
+ * @param limit The memory limit in MB.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::PixPoolLimit(const int limit) {
+    m_pixPoolLimit = limit;
+}
+
+/**
+ * Sets the number of pages recognized in parallel, every thread holds an ocr engine of its own.
+ *
+ * @param threads The number of threads, 0 for one per hardware thread.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::OcrThreads(const int threads) {
+    m_ocrThreads = threads;
+}
+
+/**
+ * Sets the memory available for output files held in memory (memfd) instead of on disk.
+ *
+ * @param limit The memory limit in MB, 0 to write all output files to disk.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::MemoryFileLimit(const int limit) {
+    m_memoryFileLimit = limit;
+}
+
+/**
+ * Sets the maximum number of ssh sessions open to one host at the same time.
+ *
+ * @param connections The number of sessions per host.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::ConnectionsPerHost(const int connections) {
+    m_connectionsPerHost = connections;
+}
+
+/**
+ * Sets how long an unused ssh session is kept open for the next remote operation.
+ *
+ * @param seconds The idle time in seconds, 0 to close sessions right after use.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::ConnectionIdleTimeout(const int seconds) {
+    m_connectionIdleTimeout = seconds;
+}
+
+/**
+ * Sets the number of remote files downloaded at the same time.
+ *
+ * @param transfers The number of concurrent downloads.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::ConcurrentTransfers(const int transfers) {
+    m_concurrentTransfers = transfers;
+}
+
+/**
+ * Sets the bandwidth available to all downloads together.
+ *
+ * @param limit The bandwidth in KB/s, 0 for no limit.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::BandwidthLimit(const int limit) {
+    m_bandwidthLimit = limit;
+}
+
+/**
+ * Sets the bandwidth available to the downloads from one server.
+ *
+ * @param limit The bandwidth in KB/s, 0 for no limit.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::HostBandwidthLimit(const int limit) {
+    m_hostBandwidthLimit = limit;
+}
+
+/**
+ * Sets the memory for remote files downloaded while other files are processed.
+ *
+ * @param limit The memory limit in MB, 0 to download each file only when it is processed.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::PrefetchLimit(const int limit) {
+    m_prefetchLimit = limit;
+}
+
+/**
+ * Sets the disk space for downloaded remote files kept for the next time they are opened.
+ *
+ * @param limit The disk space in MB, 0 to download each file again.
+ *
+ * @return void
+ *
+ * @throws None
+ */
+void Settings::DownloadCacheLimit(const int limit) {
+    m_downloadCacheLimit = limit;
+}
+
 /********************************** class SettingsUI **********************************
 * In the constructor the overall layout is created
 *
@@ -321,6 +516,7 @@ SettingsUI::SettingsUI (QWidget *parent) : QWidget(parent) {
     createNetworkTab();
     createDocumentTab();
     createPathTab();
+    createPerformanceTab();
     
     layoutDialog.addWidget(&qtwSettings);
     buttonBox.setStandardButtons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
@@ -360,6 +556,14 @@ void SettingsUI::createNetworkTab() {
     lePassword.setEchoMode(QLineEdit::PasswordEchoOnEdit);
     layoutNetworkForm.addRow(tr("Password: "), &lePassword);
     layoutNetworkForm.addRow(tr("Loop through subdirectories: "), &cbRecursive);
+    cbRemoteFind.setToolTip(tr("Lists the directory with a single find command on the server. Needs shell access, falls back to SFTP otherwise."));
+    layoutNetworkForm.addRow(tr("List with remote find: "), &cbRemoteFind);
+    cbIncremental.setToolTip(tr("Remembers the files of the last scan and skips them unless they changed."));
+    layoutNetworkForm.addRow(tr("Only new or changed files: "), &cbIncremental);
+    cbClaiming.setToolTip(tr("Moves the files into a folder of this instance before processing them, so instances sharing the directory do not process a file twice."));
+    layoutNetworkForm.addRow(tr("Shared with other instances: "), &cbClaiming);
+    cbPolling.setToolTip(tr("Checks the directory for new files in the background, more often while files arrive. A file is taken once it stopped changing."));
+    layoutNetworkForm.addRow(tr("Check for new files automatically: "), &cbPolling);
 
     // Create DocumentProfile entries
     for (int i=0; i < settings.documentProfileCount(); i++) {
@@ -413,6 +617,10 @@ void SettingsUI::createNetworkTab() {
     QObject::connect(&leUsername, &QLineEdit::editingFinished, this, &SettingsUI::updateVector);
     QObject::connect(&lePassword, &QLineEdit::editingFinished, this, &SettingsUI::updateVector);    
     QObject::connect(&cbRecursive, &QCheckBox::stateChanged, this, &SettingsUI::updateVector);
+    QObject::connect(&cbRemoteFind, &QCheckBox::stateChanged, this, &SettingsUI::updateVector);
+    QObject::connect(&cbIncremental, &QCheckBox::stateChanged, this, &SettingsUI::updateVector);
+    QObject::connect(&cbClaiming, &QCheckBox::stateChanged, this, &SettingsUI::updateVector);
+    QObject::connect(&cbPolling, &QCheckBox::stateChanged, this, &SettingsUI::updateVector);
     QObject::connect(&cbDocumentProfileName, &QComboBox::currentTextChanged, this, &SettingsUI::updateVector);
 
     // Load all network profiles
@@ -453,6 +661,10 @@ void SettingsUI::changedNetworkProfile(int currentRow) {
     leUsername.setText(QString::fromStdString(settings.NetworkProfile(currentRow)->url.Username()));
     lePassword.setText(QString::fromStdString(settings.NetworkProfile(currentRow)->url.Password()));
     cbRecursive.setChecked(settings.NetworkProfile(currentRow)->isRecursive);
+    cbRemoteFind.setChecked(settings.NetworkProfile(currentRow)->isRemoteFind);
+    cbIncremental.setChecked(settings.NetworkProfile(currentRow)->isIncremental);
+    cbClaiming.setChecked(settings.NetworkProfile(currentRow)->isClaiming);
+    cbPolling.setChecked(settings.NetworkProfile(currentRow)->isPolling);
     cbDocumentProfileName.setCurrentIndex(settings.NetworkProfile(currentRow)->documentProfileIndex);
 }
 
@@ -578,7 +790,8 @@ void SettingsUI::updateDocumentProfiles(int index) {
     {
         netWorkTab = 0,
         documentTab = 1,
-        pathTab = 2
+        pathTab = 2,
+        performanceTab = 3
     };
 
     if (index == tabIndex::netWorkTab) {
@@ -627,6 +840,18 @@ void SettingsUI::updateVector() {
         else if (senderObject == &cbRecursive) {
             settings.NetworkProfile(profileIndexNetwork)->isRecursive = cbRecursive.isChecked();
         }
+        else if (senderObject == &cbRemoteFind) {
+            settings.NetworkProfile(profileIndexNetwork)->isRemoteFind = cbRemoteFind.isChecked();
+        }
+        else if (senderObject == &cbIncremental) {
+            settings.NetworkProfile(profileIndexNetwork)->isIncremental = cbIncremental.isChecked();
+        }
+        else if (senderObject == &cbClaiming) {
+            settings.NetworkProfile(profileIndexNetwork)->isClaiming = cbClaiming.isChecked();
+        }
+        else if (senderObject == &cbPolling) {
+            settings.NetworkProfile(profileIndexNetwork)->isPolling = cbPolling.isChecked();
+        }
         else if (senderObject == &cbDocumentProfileName) {
             settings.NetworkProfile(profileIndexNetwork)->documentProfileName = cbDocumentProfileName.currentText().toStdString();
             settings.NetworkProfile(profileIndexNetwork)->documentProfileIndex = cbDocumentProfileName.currentIndex();
@@ -646,11 +871,45 @@ void SettingsUI::updateVector() {
         else if (senderObject == &cbIsColored) {
             settings.DocumentProfile(profileIndexDocument)->isColored = cbIsColored.isChecked();
         }
+        else if (senderObject == &cbCropBorders) {
+            settings.DocumentProfile(profileIndexDocument)->cropBorders = cbCropBorders.isChecked();
+        }
+        else if (senderObject == &cbMixedRasterContent) {
+            settings.DocumentProfile(profileIndexDocument)->mixedRasterContent = cbMixedRasterContent.isChecked();
+        }
+        else if (senderObject == &cbJbig2) {
+            settings.DocumentProfile(profileIndexDocument)->jbig2 = cbJbig2.isChecked();
+        }
+        else if (senderObject == &cbLinearized) {
+            settings.DocumentProfile(profileIndexDocument)->linearized = cbLinearized.isChecked();
+        }
     }
     if (senderObject == &leDestinationDir) {
         settings.DestinationDir(leDestinationDir.text());
     } else if (senderObject == &leSSHDir) {
         settings.SSHKeyPath(leSSHDir.text());
+    } else if (senderObject == &leRemoteArchiveDir) {
+        settings.RemoteArchiveDir(leRemoteArchiveDir.text());
+    } else if (senderObject == &sbPixPoolLimit) {
+        settings.PixPoolLimit(sbPixPoolLimit.value());
+    } else if (senderObject == &sbOcrThreads) {
+        settings.OcrThreads(sbOcrThreads.value());
+    } else if (senderObject == &sbMemoryFileLimit) {
+        settings.MemoryFileLimit(sbMemoryFileLimit.value());
+    } else if (senderObject == &sbConnectionsPerHost) {
+        settings.ConnectionsPerHost(sbConnectionsPerHost.value());
+    } else if (senderObject == &sbConnectionIdleTimeout) {
+        settings.ConnectionIdleTimeout(sbConnectionIdleTimeout.value());
+    } else if (senderObject == &sbConcurrentTransfers) {
+        settings.ConcurrentTransfers(sbConcurrentTransfers.value());
+    } else if (senderObject == &sbBandwidthLimit) {
+        settings.BandwidthLimit(sbBandwidthLimit.value());
+    } else if (senderObject == &sbHostBandwidthLimit) {
+        settings.HostBandwidthLimit(sbHostBandwidthLimit.value());
+    } else if (senderObject == &sbPrefetchLimit) {
+        settings.PrefetchLimit(sbPrefetchLimit.value());
+    } else if (senderObject == &sbDownloadCacheLimit) {
+        settings.DownloadCacheLimit(sbDownloadCacheLimit.value());
     }
 }
 
@@ -674,6 +933,10 @@ void SettingsUI::loadNetworkProfiles() {
             leUsername.setText(QString::fromStdString(settings.NetworkProfile(i)->url.Username()));
             lePassword.setText(QString::fromStdString(settings.NetworkProfile(i)->url.Password()));
             cbRecursive.setChecked(settings.NetworkProfile(i)->isRecursive);
+            cbRemoteFind.setChecked(settings.NetworkProfile(i)->isRemoteFind);
+            cbIncremental.setChecked(settings.NetworkProfile(i)->isIncremental);
+            cbClaiming.setChecked(settings.NetworkProfile(i)->isClaiming);
+            cbPolling.setChecked(settings.NetworkProfile(i)->isPolling);
             loadDocumentProfile();
             cbDocumentProfileName.setCurrentIndex(settings.NetworkProfile(i)->documentProfileIndex);
         }
@@ -745,6 +1008,20 @@ void SettingsUI::createDocumentTab() {
     cbIsColored.setCheckState(Qt::Unchecked);
     layoutDocumentForm.addRow(tr("Preserve colors"), &cbIsColored);
 
+    cbCropBorders.setCheckState(Qt::Checked);
+    cbCropBorders.setToolTip(tr("Removes scanner borders along the image edges and punch holes, and restricts the text recognition to the content of the page."));
+    layoutDocumentForm.addRow(tr("Crop borders"), &cbCropBorders);
+
+    // Only used together with preserved colors
+    cbMixedRasterContent.setCheckState(Qt::Unchecked);
+    layoutDocumentForm.addRow(tr("Compress colors (MRC)"), &cbMixedRasterContent);
+
+    cbJbig2.setCheckState(Qt::Unchecked);
+    layoutDocumentForm.addRow(tr("JBIG2 compression"), &cbJbig2);
+
+    cbLinearized.setCheckState(Qt::Unchecked);
+    layoutDocumentForm.addRow(tr("Fast web view (linearized)"), &cbLinearized);
+
     layoutDocumentH.addLayout(&layoutDocumentForm);
 
     pbAddDocumentProfile.setText(tr("&Add"));
@@ -785,6 +1062,10 @@ void SettingsUI::createDocumentTab() {
     QObject::connect(&sbResolution, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
     QObject::connect(&sbThresholdValue, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &SettingsUI::updateVector);
     QObject::connect(&cbIsColored, QOverload<int>::of(&QCheckBox::stateChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&cbCropBorders, QOverload<int>::of(&QCheckBox::stateChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&cbMixedRasterContent, QOverload<int>::of(&QCheckBox::stateChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&cbJbig2, QOverload<int>::of(&QCheckBox::stateChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&cbLinearized, QOverload<int>::of(&QCheckBox::stateChanged), this, &SettingsUI::updateVector);
 
     // Load document profiles
     loadDocumentProfile();
@@ -822,6 +1103,10 @@ void SettingsUI::changedDocumentProfile(int index) {
     sbResolution.setValue(settings.DocumentProfile(index)->resolution);
     sbThresholdValue.setValue(settings.DocumentProfile(index)->thresholdValue);
     cbIsColored.setChecked(settings.DocumentProfile(index)->isColored);
+    cbCropBorders.setChecked(settings.DocumentProfile(index)->cropBorders);
+    cbMixedRasterContent.setChecked(settings.DocumentProfile(index)->mixedRasterContent);
+    cbJbig2.setChecked(settings.DocumentProfile(index)->jbig2);
+    cbLinearized.setChecked(settings.DocumentProfile(index)->linearized);
 }
 
 /**
@@ -932,6 +1217,10 @@ void SettingsUI::loadDocumentProfile() {
             sbResolution.setValue(settings.DocumentProfile(i)->resolution);
             sbThresholdValue.setValue(settings.DocumentProfile(i)->thresholdValue);
             cbIsColored.setChecked(settings.DocumentProfile(i)->isColored);
+            cbCropBorders.setChecked(settings.DocumentProfile(i)->cropBorders);
+            cbMixedRasterContent.setChecked(settings.DocumentProfile(i)->mixedRasterContent);
+            cbJbig2.setChecked(settings.DocumentProfile(i)->jbig2);
+            cbLinearized.setChecked(settings.DocumentProfile(i)->linearized);
         }
     }
 }
@@ -1047,12 +1336,18 @@ void SettingsUI::createPathTab() {
     btSSHDir.setText("...");
     layoutPath.addWidget(&btSSHDir, 1, 2);
 
+    layoutPath.addWidget(&lblRemoteArchiveDir, 2, 0);
+    layoutPath.addWidget(&leRemoteArchiveDir, 2, 1);
+    leRemoteArchiveDir.setText(settings.RemoteArchiveDir());
+    leRemoteArchiveDir.setToolTip(tr("Relative to the directory of the file or absolute. Leave empty to delete the processed files."));
+
     qtwSettings.addTab(&qPathWidget, tr("Path settings"));
     QObject::connect(&btDestinationDir, &QPushButton::pressed, this, &SettingsUI::getPaths);
     QObject::connect(&btSSHDir, &QPushButton::pressed, this, &SettingsUI::getPaths);
 
     QObject::connect(&leDestinationDir, &QLineEdit::textChanged, this, &SettingsUI::updateVector);
     QObject::connect(&leSSHDir, &QLineEdit::textChanged, this, &SettingsUI::updateVector);
+    QObject::connect(&leRemoteArchiveDir, &QLineEdit::textChanged, this, &SettingsUI::updateVector);
 }
 
 /**
@@ -1092,6 +1387,7 @@ void SettingsUI::getPaths() {
 void SettingsUI::setPaths() {
     leDestinationDir.setText(settings.DestinationDir());
     leSSHDir.setText(settings.SSHKeyPath());
+    leRemoteArchiveDir.setText(settings.RemoteArchiveDir());
 }
 
 /**
@@ -1128,6 +1424,92 @@ bool SettingsUI::validatePath(const QString Path) {
     return true;
 }
 
+/**
+ * Creates the Performance tab in the Settings UI, setting up the layout and connecting necessary signals.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @throws None
+ */
+void SettingsUI::createPerformanceTab() {
+    qPerformanceWidget.setLayout(&layoutPerformance);
+
+    sbPixPoolLimit.setRange(256, 65536);
+    sbPixPoolLimit.setSingleStep(256);
+    sbPixPoolLimit.setSuffix(" MB");
+    sbPixPoolLimit.setValue(settings.PixPoolLimit());
+    layoutPerformance.addRow(tr("Image memory limit: "), &sbPixPoolLimit);
+
+    sbOcrThreads.setRange(0, 256);
+    sbOcrThreads.setSpecialValueText(tr("Automatic"));
+    sbOcrThreads.setValue(settings.OcrThreads());
+    layoutPerformance.addRow(tr("Pages recognized in parallel: "), &sbOcrThreads);
+
+    sbMemoryFileLimit.setRange(0, 65536);
+    sbMemoryFileLimit.setSingleStep(256);
+    sbMemoryFileLimit.setSuffix(" MB");
+    sbMemoryFileLimit.setSpecialValueText(tr("Off"));
+    sbMemoryFileLimit.setValue(settings.MemoryFileLimit());
+    layoutPerformance.addRow(tr("Output files in memory: "), &sbMemoryFileLimit);
+
+    sbConnectionsPerHost.setRange(1, 32);
+    sbConnectionsPerHost.setValue(settings.ConnectionsPerHost());
+    layoutPerformance.addRow(tr("Connections per server: "), &sbConnectionsPerHost);
+
+    sbConnectionIdleTimeout.setRange(0, 3600);
+    sbConnectionIdleTimeout.setSuffix(" s");
+    sbConnectionIdleTimeout.setSpecialValueText(tr("Close after use"));
+    sbConnectionIdleTimeout.setValue(settings.ConnectionIdleTimeout());
+    layoutPerformance.addRow(tr("Keep idle connections: "), &sbConnectionIdleTimeout);
+
+    sbConcurrentTransfers.setRange(1, 16);
+    sbConcurrentTransfers.setValue(settings.ConcurrentTransfers());
+    layoutPerformance.addRow(tr("Parallel downloads: "), &sbConcurrentTransfers);
+
+    sbBandwidthLimit.setRange(0, 1048576);
+    sbBandwidthLimit.setSingleStep(1024);
+    sbBandwidthLimit.setSuffix(" KB/s");
+    sbBandwidthLimit.setSpecialValueText(tr("Unlimited"));
+    sbBandwidthLimit.setValue(settings.BandwidthLimit());
+    layoutPerformance.addRow(tr("Download bandwidth: "), &sbBandwidthLimit);
+
+    sbHostBandwidthLimit.setRange(0, 1048576);
+    sbHostBandwidthLimit.setSingleStep(1024);
+    sbHostBandwidthLimit.setSuffix(" KB/s");
+    sbHostBandwidthLimit.setSpecialValueText(tr("Unlimited"));
+    sbHostBandwidthLimit.setValue(settings.HostBandwidthLimit());
+    layoutPerformance.addRow(tr("Download bandwidth per server: "), &sbHostBandwidthLimit);
+
+    sbPrefetchLimit.setRange(0, 65536);
+    sbPrefetchLimit.setSingleStep(256);
+    sbPrefetchLimit.setSuffix(" MB");
+    sbPrefetchLimit.setSpecialValueText(tr("Off"));
+    sbPrefetchLimit.setValue(settings.PrefetchLimit());
+    layoutPerformance.addRow(tr("Download ahead: "), &sbPrefetchLimit);
+
+    sbDownloadCacheLimit.setRange(0, 1048576);
+    sbDownloadCacheLimit.setSingleStep(1024);
+    sbDownloadCacheLimit.setSuffix(" MB");
+    sbDownloadCacheLimit.setSpecialValueText(tr("Off"));
+    sbDownloadCacheLimit.setValue(settings.DownloadCacheLimit());
+    layoutPerformance.addRow(tr("Keep downloaded files: "), &sbDownloadCacheLimit);
+
+    qtwSettings.addTab(&qPerformanceWidget, tr("Performance"));
+
+    QObject::connect(&sbPixPoolLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbOcrThreads, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbMemoryFileLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbConnectionsPerHost, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbConnectionIdleTimeout, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbConcurrentTransfers, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbBandwidthLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbHostBandwidthLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbPrefetchLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+    QObject::connect(&sbDownloadCacheLimit, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsUI::updateVector);
+}
+
 /**
  * Shows the settings dialog.
  *
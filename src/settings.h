@@ -43,6 +43,14 @@ public:
         std::string documentProfileName;
         int documentProfileIndex;
         ParseUrl url;
+        // List the remote directory with one find command over ssh instead of browsing it with sftp
+        bool isRemoteFind {false};
+        // Only offer files that are new or changed since the previous scan
+        bool isIncremental {false};
+        // Claim the files for this instance before processing, other instances scan the same directory
+        bool isClaiming {false};
+        // Scan the directory in the background repeatedly, offering new files once they are complete
+        bool isPolling {false};
 
         bool operator!=(const networkProfile& other) const {
             return (name != other.name);
@@ -69,6 +77,13 @@ public:
         int resolution {600};
         float thresholdValue {0.993f};
         bool isColored {false};
+        bool cropBorders {true};
+        // Colored pages are split into text mask, background and foreground
+        bool mixedRasterContent {false};
+        // Binary pages and text masks are stored as JBIG2 instead of G4
+        bool jbig2 {false};
+        // Output files are linearized for fast web view
+        bool linearized {false};
 
         bool operator!=(const documentProfile& other) const {
             return (name != other.name);
@@ -80,7 +95,11 @@ public:
         .language = Settings::Language::deu,
         .resolution = 600,
         .thresholdValue = 0.993f,
-        .isColored = false
+        .isColored = false,
+        .cropBorders = true,
+        .mixedRasterContent = false,
+        .jbig2 = false,
+        .linearized = false
     };
 
     Settings::documentProfile *DocumentProfile(unsigned int index);
@@ -97,6 +116,9 @@ public:
     void SSHKeyPath(const QString &path);
     QString SSHKeyPath() { return m_sshKeyPath; };
 
+    void RemoteArchiveDir(const QString &dir);
+    QString RemoteArchiveDir() { return m_remoteArchiveDir; }
+
     std::string TmpDir() {
         return std::filesystem::temp_directory_path().string() + "/";
     };
@@ -112,6 +134,28 @@ public:
         };
     }
 
+    /************ Performance ************/
+    void PixPoolLimit(const int limit);
+    int PixPoolLimit() { return m_pixPoolLimit; };
+    void OcrThreads(const int threads);
+    int OcrThreads() { return m_ocrThreads; };
+    void MemoryFileLimit(const int limit);
+    int MemoryFileLimit() { return m_memoryFileLimit; };
+    void ConnectionsPerHost(const int connections);
+    int ConnectionsPerHost() { return m_connectionsPerHost; };
+    void ConnectionIdleTimeout(const int seconds);
+    int ConnectionIdleTimeout() { return m_connectionIdleTimeout; };
+    void ConcurrentTransfers(const int transfers);
+    int ConcurrentTransfers() { return m_concurrentTransfers; };
+    void BandwidthLimit(const int limit);
+    int BandwidthLimit() { return m_bandwidthLimit; };
+    void HostBandwidthLimit(const int limit);
+    int HostBandwidthLimit() { return m_hostBandwidthLimit; };
+    void PrefetchLimit(const int limit);
+    int PrefetchLimit() { return m_prefetchLimit; };
+    void DownloadCacheLimit(const int limit);
+    int DownloadCacheLimit() { return m_downloadCacheLimit; };
+
     int resolution () { return documentProfiles[0]->resolution; }
     float thresholdValue() { return documentProfiles[0]->thresholdValue; }
     bool isColored() { return documentProfiles[0]->isColored; }
@@ -124,6 +168,28 @@ private:
 
     QString m_destinationDir;
     QString m_sshKeyPath;
+    // Directory on the server where processed remote files are moved to, empty to delete them
+    QString m_remoteArchiveDir;
+
+    // Memory limit of the image buffer pool in MB
+    int m_pixPoolLimit {2048};
+    // Number of pages recognized in parallel, 0 for one per hardware thread
+    int m_ocrThreads {0};
+    // Memory for output files kept in memory instead of on disk in MB, 0 to always use the disk
+    int m_memoryFileLimit {0};
+    // Pooled ssh sessions open to one host at the same time
+    int m_connectionsPerHost {4};
+    // Seconds an unused ssh session is kept open, 0 to close it right after use
+    int m_connectionIdleTimeout {60};
+    // Remote files downloaded at the same time
+    int m_concurrentTransfers {4};
+    // Download bandwidth overall and per server in KB/s, 0 for no limit
+    int m_bandwidthLimit {0};
+    int m_hostBandwidthLimit {0};
+    // Memory for remote files downloaded ahead of processing in MB, 0 to download no file ahead
+    int m_prefetchLimit {1024};
+    // Disk space for downloaded remote files in MB, 0 to cache no file
+    int m_downloadCacheLimit {2048};
 };
 
 class SettingsUI : public QWidget
@@ -145,6 +211,8 @@ class SettingsUI : public QWidget
     - Tab paths
         - default destination directory
         - ssh key path
+    - Tab performance
+        - memory limit of the image buffer pool
     - Tab Document profiles
         - Add document Profile
         - Remove document profile
@@ -155,6 +223,8 @@ class SettingsUI : public QWidget
                 - resolution
                 - threshhold method
                 - threshhold value
+                - preserve colors
+                - crop borders
     - OK, Cancel, Apply
 */
 
@@ -194,6 +264,7 @@ private:
     void createNetworkTab();
     void createDocumentTab();
     void createPathTab();
+    void createPerformanceTab();
 
     QDialog qdSettings {this};
     QVBoxLayout layoutDialog {&qdSettings};
@@ -212,6 +283,10 @@ private:
     QLineEdit leUsername;
     QLineEdit lePassword;
     QCheckBox cbRecursive;
+    QCheckBox cbRemoteFind;
+    QCheckBox cbIncremental;
+    QCheckBox cbClaiming;
+    QCheckBox cbPolling;
     QComboBox cbDocumentProfileName;
     
     QListWidget lwNetworkProfiles;
@@ -233,6 +308,10 @@ private:
     QSpinBox sbResolution;
     QDoubleSpinBox sbThresholdValue;
     QCheckBox cbIsColored;
+    QCheckBox cbCropBorders;
+    QCheckBox cbMixedRasterContent;
+    QCheckBox cbJbig2;
+    QCheckBox cbLinearized;
 
     QListWidget lwDocumentProfiles;
 
@@ -250,11 +329,28 @@ private:
     QLineEdit leDestinationDir;
     QLabel lblSSHDir {tr("Directory where to find SSH keys for passwordless login:")};
     QLineEdit leSSHDir;
+    QLabel lblRemoteArchiveDir {tr("Directory on the server where to move processed files:")};
+    QLineEdit leRemoteArchiveDir;
     QToolButton btDestinationDir;
     QToolButton btSSHDir;
 
     void setPaths();
     void getPaths();
+
+    // Performance Tab
+    QWidget qPerformanceWidget {&qtwSettings};
+    QFormLayout layoutPerformance {&qPerformanceWidget};
+    QSpinBox sbPixPoolLimit;
+    QSpinBox sbOcrThreads;
+    QSpinBox sbMemoryFileLimit;
+    QSpinBox sbConnectionsPerHost;
+    QSpinBox sbConnectionIdleTimeout;
+    QSpinBox sbConcurrentTransfers;
+    QSpinBox sbBandwidthLimit;
+    QSpinBox sbHostBandwidthLimit;
+    QSpinBox sbPrefetchLimit;
+    QSpinBox sbDownloadCacheLimit;
+
     template <typename T> void removeItem(QListWidget &listWidget, std::vector<T> &profileList);
 
     // Validator functions
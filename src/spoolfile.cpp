@@ -0,0 +1,195 @@
+#include "spoolfile.h"
+
+#include <iostream>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+//Qt 6.x
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QString>
+
+/**
+ * Opens the spool file of a version of a remote file, it is created if it does not exist.
+ *
+ * @param keyHash The hash identifying the version of the remote file, see DownloadCache::keyHash.
+ *
+ * @throws None
+ */
+SpoolFile::SpoolFile(const std::string &keyHash) : m_keyHash(keyHash), m_hash(std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256)) {
+    const std::filesystem::path directory {std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "spool"};
+    static std::once_flag expired;
+    std::call_once(expired, removeExpired, directory);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    m_fileName = directory / (keyHash + ".part");
+    m_fd = ::open(m_fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    // Another download of the same file owns the spool file
+    if (m_fd >= 0 && flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/**
+ * Closes the spool file, it is kept to resume the download later.
+ *
+ * @throws None
+ */
+SpoolFile::~SpoolFile() {
+    close();
+}
+
+/**
+ * Reads the content of an earlier, interrupted download and hashes it.
+ * Has to be called before anything is appended.
+ *
+ * @param data Receives the content.
+ * @param maxSize The size of data, a longer spool file is not used.
+ *
+ * @return The number of bytes read, the offset to resume the download at.
+ *
+ * @throws None
+ */
+uint64_t SpoolFile::load(char *data, uint64_t maxSize) {
+    if (m_fd < 0 || m_size > 0) {
+        return m_size;
+    }
+    const off_t length {lseek(m_fd, 0, SEEK_END)};
+    if (length <= 0 || static_cast<uint64_t>(length) > maxSize) {
+        restart();
+        return 0;
+    }
+
+    uint64_t offset {0};
+    while (offset < static_cast<uint64_t>(length)) {
+        const ssize_t nbytes {pread(m_fd, data + offset, length - offset, offset)};
+        if (nbytes <= 0) {
+            restart();
+            return 0;
+        }
+        offset += nbytes;
+    }
+    lseek(m_fd, length, SEEK_SET);
+    m_hash->addData(QByteArray::fromRawData(data, length));
+    m_size = length;
+
+    #ifdef DEBUG
+        std::cout << "SpoolFile::load: resuming at " << m_size << " from " << m_fileName << std::endl;
+    #endif
+    return m_size;
+}
+
+/**
+ * Appends the next bytes of the download.
+ *
+ * @param data The bytes.
+ * @param size The number of bytes.
+ *
+ * @throws None
+ */
+void SpoolFile::append(const char *data, size_t size) {
+    m_hash->addData(QByteArray::fromRawData(data, size));
+    m_size += size;
+
+    size_t offset {0};
+    while (m_fd >= 0 && offset < size) {
+        const ssize_t nbytes {write(m_fd, data + offset, size - offset)};
+        if (nbytes <= 0) {
+            std::cerr << "Error writing spool file " << m_fileName << ", the download can not be resumed" << std::endl;
+            close();
+            std::error_code error;
+            std::filesystem::remove(m_fileName, error);
+            break;
+        }
+        offset += nbytes;
+    }
+}
+
+/**
+ * Discards the content, the download starts again at the beginning.
+ *
+ * @throws None
+ */
+void SpoolFile::restart() {
+    m_hash->reset();
+    m_size = 0;
+    if (m_fd >= 0 && (ftruncate(m_fd, 0) != 0 || lseek(m_fd, 0, SEEK_SET) != 0)) {
+        close();
+    }
+}
+
+/**
+ * Removes the spool file after the download completed.
+ *
+ * @throws None
+ */
+void SpoolFile::remove() {
+    if (m_fd >= 0) {
+        std::error_code error;
+        std::filesystem::remove(m_fileName, error);
+        close();
+    }
+}
+
+/**
+ * Returns the checksum of the content.
+ *
+ * @return The SHA-256 of the content as hex string.
+ *
+ * @throws None
+ */
+std::string SpoolFile::checksum() const {
+    return m_hash->result().toHex().toStdString();
+}
+
+/**
+ * Closes the spool file and releases its lock.
+ *
+ * @throws None
+ */
+void SpoolFile::close() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/**
+ * Removes spool files not used for longer than cMaxAge.
+ *
+ * @param directory The spool directory.
+ *
+ * @throws None
+ */
+void SpoolFile::removeExpired(const std::filesystem::path &directory) {
+    std::error_code error;
+    const auto expiry {std::filesystem::file_time_type::clock::now() - cMaxAge};
+    for (const auto &file : std::filesystem::directory_iterator(directory, error)) {
+        if (file.last_write_time(error) < expiry) {
+            std::filesystem::remove(file.path(), error);
+        }
+    }
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
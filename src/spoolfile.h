@@ -0,0 +1,68 @@
+#ifndef SPOOLFILE_H
+#define SPOOLFILE_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+class QCryptographicHash;
+
+/*
+    The bytes of a download received so far, in order, on disk in the cache directory.
+    An interrupted download resumes at the end of its spool file, also after a restart,
+    as long as the remote file keeps its size and modification time.
+    The SHA-256 of the content is calculated while it is appended.
+    If the spool file can not be written or is used by another download, the content is
+    only hashed and the download can not be resumed.
+*/
+class SpoolFile {
+
+public:
+    explicit SpoolFile(const std::string &keyHash);
+    ~SpoolFile();
+    SpoolFile(const SpoolFile &) = delete;
+    SpoolFile &operator=(const SpoolFile &) = delete;
+
+    uint64_t load(char *data, uint64_t maxSize);
+    void append(const char *data, size_t size);
+    void restart();
+    void remove();
+
+    const std::string &KeyHash() const { return m_keyHash; };
+    uint64_t Size() const { return m_size; };
+    std::string checksum() const;
+
+private:
+    // Spool files of downloads that were never resumed are removed after this time
+    static constexpr std::chrono::hours cMaxAge {24 * 7};
+
+    const std::string m_keyHash;
+    std::filesystem::path m_fileName;
+    int m_fd {-1};
+    uint64_t m_size {0};
+    std::unique_ptr<QCryptographicHash> m_hash;
+
+    void close();
+    static void removeExpired(const std::filesystem::path &directory);
+};
+
+#endif // SPOOLFILE_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
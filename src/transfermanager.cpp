@@ -0,0 +1,209 @@
+#include "transfermanager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+// local
+#include "ftpconnection.h"
+
+/**
+ * Returns the process wide transfer manager.
+ *
+ * @return A reference to the TransferManager.
+ *
+ * @throws None
+ */
+TransferManager &TransferManager::instance() {
+    static TransferManager manager;
+    return manager;
+}
+
+/**
+ * Sets the limits of the transfers, running downloads are not interrupted.
+ *
+ * @param maxTransfers The maximum number of downloads at the same time.
+ * @param transfersPerHost The maximum number of downloads from one host at the same time.
+ * @param bandwidth The overall bandwidth in KB/s, 0 for no limit.
+ * @param hostBandwidth The bandwidth per host in KB/s, 0 for no limit.
+ *
+ * @throws None
+ */
+void TransferManager::Limits(int maxTransfers, int transfersPerHost, int bandwidth, int hostBandwidth) {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxTransfers = std::clamp(maxTransfers, 1, cMaxTransfers);
+        m_transfersPerHost = std::max(transfersPerHost, 1);
+        m_bandwidth.Rate(std::max(bandwidth, 0) * 1024.0);
+        m_hostRate = std::max(hostBandwidth, 0) * 1024.0;
+        for (auto &[host, limiter] : m_hostBandwidth) {
+            limiter->Rate(m_hostRate);
+        }
+    }
+    dispatch();
+}
+
+/**
+ * Queues the download of a remote file.
+ *
+ * @param url The url of the remote file.
+ * @param received Called on the download thread with the number of bytes of every reply, may be empty.
+ *
+ * @return The future content of the file, nullptr if the download failed.
+ *
+ * @throws None
+ */
+std::future<std::unique_ptr<std::string>> TransferManager::download(const ParseUrl &url, const std::function<void(size_t)> &received) {
+    std::shared_ptr<job> transfer {std::make_shared<job>()};
+    transfer->url = url;
+    transfer->host = url.Username() + "@" + url.Host() + ":" + std::to_string(url.Port());
+    transfer->received = received;
+    std::future<std::unique_ptr<std::string>> result {transfer->result.get_future()};
+
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(transfer));
+    }
+    dispatch();
+    return result;
+}
+
+/**
+ * Starts waiting downloads while the limits allow it. Downloads from a host at its
+ * limit are skipped, so a busy host does not hold back the others.
+ *
+ * @throws None
+ */
+void TransferManager::dispatch() {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_pending.begin(); it != m_pending.end() && m_active < m_maxTransfers;) {
+        int &hostActive = m_activePerHost[(*it)->host];
+        if (hostActive >= m_transfersPerHost) {
+            ++it;
+            continue;
+        }
+
+        std::unique_ptr<rateLimiter> &hostBandwidth = m_hostBandwidth[(*it)->host];
+        if (hostBandwidth == nullptr) {
+            hostBandwidth = std::make_unique<rateLimiter>();
+            hostBandwidth->Rate(m_hostRate);
+        }
+
+        hostActive++;
+        m_active++;
+        m_threadPool.detach_task([this, transfer = *it, limiter = hostBandwidth.get()] { run(transfer, *limiter); });
+        it = m_pending.erase(it);
+    }
+}
+
+/**
+ * Runs a download on a thread of the pool and starts the next waiting one afterwards.
+ *
+ * @param transfer The download.
+ * @param hostBandwidth The bandwidth limit of the download's host.
+ *
+ * @throws None
+ */
+void TransferManager::run(const std::shared_ptr<job> &transfer, rateLimiter &hostBandwidth) {
+    const auto startTime {std::chrono::steady_clock::now()};
+    // Bytes received from the server, a file served from the DownloadCache has none
+    size_t size {0};
+    try {
+        FtpConnection ftpConnection(transfer->url);
+        std::unique_ptr<std::string> data {ftpConnection.getFilePtr([this, &hostBandwidth, &transfer, &size](size_t bytes) {
+            size += bytes;
+            m_bandwidth.consume(bytes);
+            hostBandwidth.consume(bytes);
+            if (transfer->received) {
+                transfer->received(bytes);
+            }
+        })};
+        if (data == nullptr) {
+            size = 0;
+        }
+        transfer->result.set_value(std::move(data));
+    }
+    catch (const std::exception &e) {
+        std::cerr << "Error downloading " << transfer->url.Filename() << ": " << e.what() << std::endl;
+        transfer->result.set_value(nullptr);
+    }
+
+    const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()};
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_active--;
+        m_activePerHost[transfer->host]--;
+        if (size > 0 && seconds > 0.0) {
+            const double rate {size / seconds};
+            m_downloadRate = (m_downloadRate > 0.0) ? (1.0 - cRateWeight) * m_downloadRate + cRateWeight * rate : rate;
+        }
+    }
+    dispatch();
+}
+
+/**
+ * Returns the average rate of a single download, measured from the start to the end of
+ * the recent downloads including their bandwidth limits.
+ *
+ * @return The rate in bytes per second, 0 if no download finished yet.
+ *
+ * @throws None
+ */
+double TransferManager::DownloadRate() {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return m_downloadRate;
+}
+
+/******************** class TransferManager::rateLimiter *********************/
+
+/**
+ * Sets the rate of the limiter.
+ *
+ * @param bytesPerSecond The rate in bytes per second, 0 for no limit.
+ *
+ * @throws None
+ */
+void TransferManager::rateLimiter::Rate(double bytesPerSecond) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_rate = bytesPerSecond;
+}
+
+/**
+ * Accounts for received bytes and sleeps until they fit into the rate.
+ * Several transfers sharing the limiter are delayed in the order they arrive.
+ *
+ * @param bytes The number of bytes received.
+ *
+ * @throws None
+ */
+void TransferManager::rateLimiter::consume(size_t bytes) {
+    std::chrono::steady_clock::time_point wakeUp;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_rate <= 0.0) {
+            return;
+        }
+        const auto now {std::chrono::steady_clock::now()};
+        m_next = std::max(m_next, now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(cBurst));
+        m_next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(bytes / m_rate));
+        wakeUp = m_next;
+    }
+    std::this_thread::sleep_until(wakeUp);
+}
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */
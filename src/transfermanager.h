@@ -0,0 +1,103 @@
+#ifndef TRANSFERMANAGER_H
+#define TRANSFERMANAGER_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// From https://github.com/bshoshany/thread-pool:
+#include "BS_thread_pool.hpp"
+
+// local
+#include "parseurl.h"
+
+/*
+    Process wide queue of remote downloads.
+    Up to maxTransfers downloads run at the same time, each on a session of its own from
+    the SessionPool, at most transfersPerHost of them to the same host. Waiting downloads
+    are started in the order they were requested, skipping hosts at their limit.
+    The received data is paced by a global and a per host bandwidth limit.
+*/
+class TransferManager {
+
+public:
+    static TransferManager &instance();
+
+    std::future<std::unique_ptr<std::string>> download(const ParseUrl &url, const std::function<void(size_t)> &received = nullptr);
+    void Limits(int maxTransfers, int transfersPerHost, int bandwidth, int hostBandwidth);
+    double DownloadRate();
+
+private:
+    TransferManager() = default;
+    TransferManager(const TransferManager &) = delete;
+    TransferManager &operator=(const TransferManager &) = delete;
+
+    // Paces a byte stream to a rate, bursts up to cBurst are passed without delay
+    class rateLimiter {
+    public:
+        void Rate(double bytesPerSecond);
+        void consume(size_t bytes);
+
+    private:
+        static constexpr std::chrono::milliseconds cBurst {250};
+
+        std::mutex m_mutex;
+        double m_rate {0.0};
+        std::chrono::steady_clock::time_point m_next;
+    };
+
+    struct job {
+        ParseUrl url;
+        std::string host;
+        std::promise<std::unique_ptr<std::string>> result;
+        std::function<void(size_t)> received;
+    };
+
+    static constexpr int cMaxTransfers = 16;
+
+    std::mutex m_mutex;
+    std::deque<std::shared_ptr<job>> m_pending;
+    std::map<std::string, int> m_activePerHost;
+    int m_active {0};
+
+    int m_maxTransfers {4};
+    int m_transfersPerHost {4};
+
+    rateLimiter m_bandwidth;
+    std::map<std::string, std::unique_ptr<rateLimiter>> m_hostBandwidth;
+    double m_hostRate {0.0};
+
+    // Moving average of the rate of a single download in bytes per second, 0 until one finished
+    double m_downloadRate {0.0};
+    static constexpr double cRateWeight = 0.3;
+
+    // Declared last, so it is destroyed first and waits for the running downloads
+    BS::thread_pool m_threadPool {cMaxTransfers};
+
+    void dispatch();
+    void run(const std::shared_ptr<job> &transfer, rateLimiter &hostBandwidth);
+};
+
+#endif // TRANSFERMANAGER_H
+
+/*  scan2ocr takes a pdf file, transcodes it to TIFF G4 and assists in renaming the file.
+    Copyright (C) 2024 Simon-Friedrich Böttger email (at) simonboettger . de
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>
+    */